@@ -5,4 +5,67 @@
 #define FUNCONF_SYSTEM_CORE_CLOCK 8000000
 #define CH32V003                  1
 
+// LED matrix size and timing, the timer constants are derived from these
+//  - LED_MATRIX_NUM_PINS:   Charlieplexed pins, lighting NUM_PINS x (NUM_PINS - 1) LEDs.
+//  - LED_MATRIX_REFRESH_HZ: Frames per second, every LED is refreshed once a frame.
+//  - LED_MATRIX_PWM_BITS:   Brightness resolution, 2^bits + 1 levels (linear, event) or 2^bits levels (BAM).
+//  - LED_MATRIX_ISR_BUDGET: The build fails if the estimated ISR load is over this percentage of the core clock.
+#define LED_MATRIX_NUM_PINS   6
+#define LED_MATRIX_REFRESH_HZ 104
+#define LED_MATRIX_PWM_BITS   4
+#define LED_MATRIX_ISR_BUDGET 50
+
+// Orientation of the board as mounted, turned clockwise by LED_ORIENT_0, LED_ORIENT_90, LED_ORIENT_180 or
+// LED_ORIENT_270 and then mirrored left to right with LED_MATRIX_MIRROR 1. led_set_pixel() and the text follow it.
+#define LED_MATRIX_ORIENTATION LED_ORIENT_0
+#define LED_MATRIX_MIRROR      0
+
+// Pack the duty cycles of two LEDs into a byte, halving the frame buffers. Needs LED_MATRIX_PWM_BITS of 4 or less,
+// and caps the linear and event PWM at 15 of 16 ticks.
+#define LED_MATRIX_PACKED 0
+
+// Scroll with led_scroll(), the scan starts reading the frame at an offset instead of the duty cycles being moved.
+// Needs LED_SKIP_DARK_OFF and an ISR scan, not LED_TIMER_DMA.
+#define LED_MATRIX_SCROLL 0
+
+// Frames in the queue of led_queue_push(), 0 for none. The scan shows queued frames at the refresh clock, each for
+// its own number of frames. Needs LED_SKIP_DARK_OFF and an ISR scan, not LED_TIMER_DMA.
+#define LED_MATRIX_QUEUE 0
+
+// Pixel columns of the led_marquee_render() text, a byte each. A 5x6 glyph with a blank column takes 6.
+#define LED_MATRIX_MARQUEE_COLUMNS 128
+
+// LED matrix scan mode
+//  - 0: Light one LED at a time, each LED gets 1/30 duty.
+//  - 1: Light all LEDs of a row at a time, each LED gets 1/6 duty with 5x fewer interrupts.
+#define LED_MATRIX_SCAN_ROWS 0
+
+// Drive the LED matrix with precomputed CFGLR/BSHR words instead of per-pin read-modify-write
+#define LED_MATRIX_PORT_TABLES 1
+
+// Timer running the LED matrix
+//  - LED_TIMER_SYSTICK: SysTick, Delay_Ms() still works but there is no system tick.
+//  - LED_TIMER_TIM1:    Compare channel 1 of TIM1, SysTick counts milliseconds in systick_millis.
+//  - LED_TIMER_TIM2:    Compare channel 1 of TIM2, SysTick counts milliseconds in systick_millis.
+//  - LED_TIMER_DMA:     TIM1 and TIM2 trigger DMA, no CPU time at all, SysTick counts milliseconds in systick_millis.
+//                       Needs LED_MATRIX_SCAN_ROWS and LED_PWM_LINEAR.
+#define LED_MATRIX_TIMER LED_TIMER_SYSTICK
+
+// LED PWM engine
+//  - LED_PWM_LINEAR: 2^LED_MATRIX_PWM_BITS ticks a slot, an interrupt every tick.
+//  - LED_PWM_BAM:    Bit-angle modulation, an interrupt per bit, LED_MATRIX_PWM_BITS 8 gives 256 levels cheaply.
+//  - LED_PWM_EVENT:  2^LED_MATRIX_PWM_BITS ticks a slot, an interrupt only when an LED turns on or off.
+#define LED_MATRIX_PWM LED_PWM_LINEAR
+
+// Skip the slots with no LED lit
+//  - LED_SKIP_DARK_OFF:        Scan every slot.
+//  - LED_SKIP_DARK_FRAME:      Lit slots are stretched to fill the frame, brighter when few LEDs are lit.
+//  - LED_SKIP_DARK_BRIGHTNESS: Lit slots keep their length, then one idle step to the end of the frame, fewer
+//                              interrupts.
+#define LED_MATRIX_SKIP_DARK LED_SKIP_DARK_OFF
+
+// Measure the matrix ISR with SysTick->CNT, type 'p' in `make monitor` (minichlink -T) to print the counters.
+// It adds about 30 cycles an interrupt, the default linear one-LED scan then needs LED_MATRIX_ISR_BUDGET 60.
+#define LED_MATRIX_PROFILE 0
+
 #endif
@@ -0,0 +1,189 @@
+// Generated by tools/font_compiler from fonts/led_font.txt, run `make font` instead of editing.
+// 123 glyphs, 492 bytes as 30-bit words, 770 bytes as columns.
+
+#define LED_FONT_ENCODING LED_FONT_FIXED
+#define LED_FONT_GLYPHS   123
+#define LED_FONT_FIRST    27
+#define LED_FONT_LAST     126
+#define LED_GLYPH_BLOCKS  308
+
+static const uint32_t font[LED_FONT_GLYPHS] LED_ASSET = {
+    0b00001000111011111111111111101010,  // U+001B heart
+    0b00111111111111111111111111111111,  // U+001C full square
+    0b00111111000110001100011000111111,  // U+001D square
+    0b00000000111001010010100111000000,  // U+001E smaller square
+    0b00000000000000100001000000000000,  // U+001F micro square
+    0b00000000000000000000000000000000,  // U+0020 space
+    0b00001000000000100001000010000100,  // U+0021 '!'
+    0b00000000000000000000000101001010,  // U+0022 '"'
+    0b00010101111101010010101111101010,  // U+0023 '#'
+    0b00001000111110100001011111000100,  // U+0024 '$'
+    0b00100011001000100010011000100000,  // U+0025 '%'
+    0b00101100100110101000100010100010,  // U+0026 '&'
+    0b00000000000000000000000010000100,  // U+0027 '''
+    0b00010000010000100001000010001000,  // U+0028 '('
+    0b00000100010000100001000010000010,  // U+0029 ')'
+    0b00001001010101110101010010000000,  // U+002A '*'
+    0b00001000010011111001000010000000,  // U+002B '+'
+    0b00000010011000110000000000000000,  // U+002C ','
+    0b00000000000011111000000000000000,  // U+002D '-'
+    0b00000000011000110000000000000000,  // U+002E '.'
+    0b00000010001000100010001000000000,  // U+002F '/'
+    0b00011101000110101101011000101110,  // U+0030 '0'
+    0b00011100010000100001000011000100,  // U+0031 '1'
+    0b00111110001000100010001000101110,  // U+0032 '2'
+    0b00011101000110000010001000101110,  // U+0033 '3'
+    0b00010000100011111010100110001000,  // U+0034 '4'
+    0b00011111000010000011110000101111,  // U+0035 '5'
+    0b00011101000110001011110001001100,  // U+0036 '6'
+    0b00001000010000100010001000011111,  // U+0037 '7'
+    0b00011101000110001011101000101110,  // U+0038 '8'
+    0b00011001000011110100011000101110,  // U+0039 '9'
+    0b00000000010000000000000010000000,  // U+003A ':'
+    0b00000100010000000000000010000000,  // U+003B ';'
+    0b00010000010000010001000100000000,  // U+003C '<'
+    0b00000001111100000111110000000000,  // U+003D '='
+    0b00000100010001000001000001000000,  // U+003E '>'
+    0b00001000000001100100001000101110,  // U+003F '?'
+    0b00000100110110101111011000101110,  // U+0040 '@'
+    0b00100011000110001111111000101110,  // U+0041 'A'
+    0b00011111000110001011111000101111,  // U+0042 'B'
+    0b00011101000100001000011000101110,  // U+0043 'C'
+    0b00011111000110001100011000101111,  // U+0044 'D'
+    0b00111110000100001011110000111111,  // U+0045 'E'
+    0b00000010000100001011110000111111,  // U+0046 'F'
+    0b00011101000110001110010000101110,  // U+0047 'G'
+    0b00100011000110001111111000110001,  // U+0048 'H'
+    0b00011100010000100001000010001110,  // U+0049 'I'
+    0b00001100100101000010000100011100,  // U+004A 'J'
+    0b00100010100100101000110010101001,  // U+004B 'K'
+    0b00111110000100001000010000100001,  // U+004C 'L'
+    0b00100011000110001101011101110001,  // U+004D 'M'
+    0b00100011000111001101011001110001,  // U+004E 'N'
+    0b00011101000110001100011000101110,  // U+004F 'O'
+    0b00000010000100001011111000101111,  // U+0050 'P'
+    0b00101100100110001100011000101110,  // U+0051 'Q'
+    0b00100010100100101011111000101111,  // U+0052 'R'
+    0b00011111000010000011100000111110,  // U+0053 'S'
+    0b00001000010000100001000010011111,  // U+0054 'T'
+    0b00011101000110001100011000110001,  // U+0055 'U'
+    0b00001000101010001100011000110001,  // U+0056 'V'
+    0b00010101010110101100011000110001,  // U+0057 'W'
+    0b00100011000101010001000101010001,  // U+0058 'X'
+    0b00001000010000100010101000110001,  // U+0059 'Y'
+    0b00111110000100010001000100011111,  // U+005A 'Z'
+    0b00011000010000100001000010001100,  // U+005B '['
+    0b00100000100000100000100000100000,  // U+005C '\'
+    0b00001100010000100001000010000110,  // U+005D ']'
+    0b00000000000010001010100010000000,  // U+005E '^'
+    0b00111110000000000000000000000000,  // U+005F '_'
+    0b00000000000000000000000010000010,  // U+0060 '`'
+    0b00101100100101001011100000000000,  // U+0061 'a'
+    0b00001110100101001001110000100001,  // U+0062 'b'
+    0b00011100000100001011100000000000,  // U+0063 'c'
+    0b00011100100101001011100100001000,  // U+0064 'd'
+    0b00011100000101111100010111000000,  // U+0065 'e'
+    0b00000100001000010001110001001100,  // U+0066 'f'
+    0b00001110100001110010010111000000,  // U+0067 'g'
+    0b00010010100101001001110000100001,  // U+0068 'h'
+    0b00000100001000010000110000000010,  // U+0069 'i'
+    0b00000110010000100001100000000100,  // U+006A 'j'
+    0b00010010010100011001010100100001,  // U+006B 'k'
+    0b00000100001000010000100001000010,  // U+006C 'l'
+    0b00101011010110101010110000000000,  // U+006D 'm'
+    0b00010010100101001001110000000000,  // U+006E 'n'
+    0b00001100100101001001100000000000,  // U+006F 'o'
+    0b00000010000100111010010011100000,  // U+0070 'p'
+    0b00010000100001110010010111000000,  // U+0071 'q'
+    0b00000100001010010011010000000000,  // U+0072 'r'
+    0b00001110100000110000010111000000,  // U+0073 's'
+    0b00011000001000010001110001000000,  // U+0074 't'
+    0b00001100100101001010010000000000,  // U+0075 'u'
+    0b00001000101010001100010000000000,  // U+0076 'v'
+    0b00010101010110101100010000000000,  // U+0077 'w'
+    0b00100010101000100010101000100000,  // U+0078 'x'
+    0b00011101000011100100101001000000,  // U+0079 'y'
+    0b00011110001000100011110000000000,  // U+007A 'z'
+    0b00110000010000110001001100000000,  // U+007B '{'
+    0b00001000010000000001000010000000,  // U+007C '|'
+    0b00000110010001100001000001100000,  // U+007D '}'
+    0b00000000100010101000100000000000,  // U+007E '~'
+    0b00001000111000101001010111000100,  // U+00A2 cent sign
+    0b00111110001000111000101001001100,  // U+00A3 pound sign
+    0b00001001111100100111110101010001,  // U+00A5 yen sign
+    0b00000000000000000000100010100010,  // U+00B0 degree sign
+    0b00100011000111111100010111010001,  // U+00C4 A diaeresis
+    0b00011101000110001100010111010001,  // U+00D6 O diaeresis
+    0b00011101000110001100010000001010,  // U+00DC U diaeresis
+    0b00011010100101001001110100100110,  // U+00DF sharp s
+    0b00101100100101001011100010000010,  // U+00E0 a grave
+    0b00101100100101001011100010001000,  // U+00E1 a acute
+    0b00101100100101001011100100100000,  // U+00E4 a diaeresis
+    0b00001000111000001000010111000000,  // U+00E7 c cedilla
+    0b00011100000101111100010111000010,  // U+00E8 e grave
+    0b00011100000101111100010111001000,  // U+00E9 e acute
+    0b00011100000101111100010111000100,  // U+00EA e circumflex
+    0b00010010100101001001110010101010,  // U+00F1 n tilde
+    0b00001100100101001001100100100000,  // U+00F6 o diaeresis
+    0b00001100100101001000000100100000,  // U+00FC u diaeresis
+    0b00111000111100010011110001011100,  // U+20AC euro sign
+    0b00001000001011111000100010000000,  // U+2190 leftwards arrow
+    0b00001000010000100101010111000100,  // U+2191 upwards arrow
+    0b00001000100011111010000010000000,  // U+2192 rightwards arrow
+    0b00001000111010101001000010000100,  // U+2193 downwards arrow
+};
+
+static const uint8_t led_glyph_map[LED_GLYPH_BLOCKS] LED_ASSET = {
+    [0x00a0 >> 5] = 1,
+    [0x00c0 >> 5] = 2,
+    [0x00e0 >> 5] = 3,
+    [0x20a0 >> 5] = 4,
+    [0x2180 >> 5] = 5,
+    [0x25a0 >> 5] = 6,
+    [0x2660 >> 5] = 7,
+};
+
+static const uint8_t led_glyph_blocks[7][32] LED_ASSET = {
+    {
+        LED_GLYPH_AT(0x00a2, 100),  // U+00A2 cent sign
+        LED_GLYPH_AT(0x00a3, 101),  // U+00A3 pound sign
+        LED_GLYPH_AT(0x00a5, 102),  // U+00A5 yen sign
+        LED_GLYPH_AT(0x00b0, 103),  // U+00B0 degree sign
+        LED_GLYPH_AT(0x00b7, 4),    // U+00B7 as U+001F micro square
+    },
+    {
+        LED_GLYPH_AT(0x00c4, 104),  // U+00C4 A diaeresis
+        LED_GLYPH_AT(0x00d6, 105),  // U+00D6 O diaeresis
+        LED_GLYPH_AT(0x00dc, 106),  // U+00DC U diaeresis
+        LED_GLYPH_AT(0x00df, 107),  // U+00DF sharp s
+    },
+    {
+        LED_GLYPH_AT(0x00e0, 108),  // U+00E0 a grave
+        LED_GLYPH_AT(0x00e1, 109),  // U+00E1 a acute
+        LED_GLYPH_AT(0x00e4, 110),  // U+00E4 a diaeresis
+        LED_GLYPH_AT(0x00e7, 111),  // U+00E7 c cedilla
+        LED_GLYPH_AT(0x00e8, 112),  // U+00E8 e grave
+        LED_GLYPH_AT(0x00e9, 113),  // U+00E9 e acute
+        LED_GLYPH_AT(0x00ea, 114),  // U+00EA e circumflex
+        LED_GLYPH_AT(0x00f1, 115),  // U+00F1 n tilde
+        LED_GLYPH_AT(0x00f6, 116),  // U+00F6 o diaeresis
+        LED_GLYPH_AT(0x00fc, 117),  // U+00FC u diaeresis
+    },
+    {
+        LED_GLYPH_AT(0x20ac, 118),  // U+20AC euro sign
+    },
+    {
+        LED_GLYPH_AT(0x2190, 119),  // U+2190 leftwards arrow
+        LED_GLYPH_AT(0x2191, 120),  // U+2191 upwards arrow
+        LED_GLYPH_AT(0x2192, 121),  // U+2192 rightwards arrow
+        LED_GLYPH_AT(0x2193, 122),  // U+2193 downwards arrow
+    },
+    {
+        LED_GLYPH_AT(0x25a0, 1),    // U+25A0 as U+001C full square
+        LED_GLYPH_AT(0x25a1, 2),    // U+25A1 as U+001D square
+        LED_GLYPH_AT(0x25ab, 3),    // U+25AB as U+001E smaller square
+    },
+    {
+        LED_GLYPH_AT(0x2665, 0),    // U+2665 as U+001B heart
+    },
+};
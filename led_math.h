@@ -0,0 +1,129 @@
+/*
+ * Fixed-point math for effects without the M extension
+ *
+ * The core is rv32ec, a `*`, `/` or `%` of two variables is a call to __mulsi3, __divsi3 or __modsi3 of libgcc, which
+ * work bit by bit on 32-bit operands. The functions here take 8-bit values, with tables and at most 8 shift-add steps:
+ *  - Angles are 0 to 255 for a full turn, led_sin() and led_cos() read a quarter-wave table.
+ *  - LED_MUL_K() multiplies by a constant with a shift and an add per set bit, led_mul8() by a variable.
+ *  - led_div8() and led_mod8() divide by a variable through a reciprocal table.
+ *  - led_scale8(), led_lerp8() and the led_ease_*() curves take a fraction t of 0 to 255 for 0 to 1, both ends exact.
+ *
+ * `make math_check` compares every input against plain arithmetic on the host, type 'm' in `make monitor` with
+ * LED_MATRIX_PROFILE to time them against libgcc on the chip.
+ */
+
+#ifndef _LED_MATH_H
+#define _LED_MATH_H
+
+#include <stdint.h>
+
+// x times a constant k of 0 to 255, folds to the shifts and adds of the bits set in k. x is evaluated once per bit.
+#define LED_MUL_BIT(x, k, b) (((k) >> (b) & 1) ? (uint32_t)(x) << (b) : 0)
+#define LED_MUL_K(x, k)                                                                                            \
+    (LED_MUL_BIT(x, k, 0) + LED_MUL_BIT(x, k, 1) + LED_MUL_BIT(x, k, 2) + LED_MUL_BIT(x, k, 3) +                   \
+     LED_MUL_BIT(x, k, 4) + LED_MUL_BIT(x, k, 5) + LED_MUL_BIT(x, k, 6) + LED_MUL_BIT(x, k, 7))
+
+// sin(i / 256 turn) x 255 for the first quarter, i from 0 to 64, a Taylor series folded at compile time
+#define LED_SIN_X(i) ((i) * 3.14159265358979 / 128)
+#define LED_SIN_T(x) ((x) * (1 - (x) * (x) / 6 * (1 - (x) * (x) / 20 * (1 - (x) * (x) / 42 * (1 - (x) * (x) / 72)))))
+#define LED_SIN(i)   (uint8_t)(LED_SIN_T(LED_SIN_X(i)) * 255 + 0.5)
+#define LED_SIN4(i)  LED_SIN(i), LED_SIN((i) + 1), LED_SIN((i) + 2), LED_SIN((i) + 3)
+#define LED_SIN16(i) LED_SIN4(i), LED_SIN4((i) + 4), LED_SIN4((i) + 8), LED_SIN4((i) + 12)
+
+static const uint8_t led_sine[65] = {
+    LED_SIN16(0), LED_SIN16(16), LED_SIN16(32), LED_SIN16(48), LED_SIN(64),
+};
+
+// 65536 / n rounded up for n from 2 to 255, x * led_reciprocals[n] >> 16 is then x / n for every 8-bit x
+#define LED_RECIPROCAL(n) ((n) < 2 ? 0 : (65535 + (n)) / (n))
+#define LED_RECIPROCAL4(n) \
+    LED_RECIPROCAL(n), LED_RECIPROCAL((n) + 1), LED_RECIPROCAL((n) + 2), LED_RECIPROCAL((n) + 3)
+#define LED_RECIPROCAL16(n) \
+    LED_RECIPROCAL4(n), LED_RECIPROCAL4((n) + 4), LED_RECIPROCAL4((n) + 8), LED_RECIPROCAL4((n) + 12)
+#define LED_RECIPROCAL64(n) \
+    LED_RECIPROCAL16(n), LED_RECIPROCAL16((n) + 16), LED_RECIPROCAL16((n) + 32), LED_RECIPROCAL16((n) + 48)
+
+static const uint16_t led_reciprocals[256] = {
+    LED_RECIPROCAL64(0),
+    LED_RECIPROCAL64(64),
+    LED_RECIPROCAL64(128),
+    LED_RECIPROCAL64(192),
+};
+
+// sin of angle a, -255 to 255
+static inline int16_t led_sin(uint8_t a)
+{
+    uint8_t i = a & 0x3f;
+    uint8_t s = led_sine[(a & 0x40) ? 64 - i : i];
+    return (a & 0x80) ? -s : s;
+}
+
+// cos of angle a, -255 to 255
+static inline int16_t led_cos(uint8_t a)
+{
+    return led_sin(a + 64);
+}
+
+// sin of angle a moved to 0 to 255, for brightness
+static inline uint8_t led_wave8(uint8_t a)
+{
+    return (255 + led_sin(a)) >> 1;
+}
+
+// x times y, 8 steps of shift and add
+static inline uint32_t led_mul8(uint8_t x, uint32_t y)
+{
+    uint32_t r = 0;
+    for (; x != 0; x >>= 1, y <<= 1)
+    {
+        if (x & 0x01)
+        {
+            r += y;
+        }
+    }
+    return r;
+}
+
+// x / n, and 0 for n of 0
+static inline uint8_t led_div8(uint8_t x, uint8_t n)
+{
+    return (n < 2) ? x & -n : led_mul8(x, led_reciprocals[n]) >> 16;
+}
+
+// x % n, and x for n of 0
+static inline uint8_t led_mod8(uint8_t x, uint8_t n)
+{
+    return x - led_mul8(led_div8(x, n), n);
+}
+
+// x * (s + 1) / 256, x scaled by s from 0 for 0 to x for 255
+static inline uint8_t led_scale8(uint8_t x, uint8_t s)
+{
+    return (led_mul8(s, x) + x) >> 8;
+}
+
+// From a for t of 0 to b for t of 255
+static inline uint8_t led_lerp8(uint8_t a, uint8_t b, uint8_t t)
+{
+    return (b >= a) ? a + led_scale8(b - a, t) : a - led_scale8(a - b, t);
+}
+
+// Starts slow, quadratic
+static inline uint8_t led_ease_in8(uint8_t t)
+{
+    return led_scale8(t, t);
+}
+
+// Ends slow, quadratic
+static inline uint8_t led_ease_out8(uint8_t t)
+{
+    return 255 - led_ease_in8(255 - t);
+}
+
+// Starts and ends slow, the two quadratic halves meet at t of 128
+static inline uint8_t led_ease_in_out8(uint8_t t)
+{
+    return (t & 0x80) ? 255 - (led_ease_in8((255 - t) << 1) >> 1) : led_ease_in8(t << 1) >> 1;
+}
+
+#endif
@@ -11,276 +11,2305 @@
  *  - GitHub: https://github.com/limingjie/
  */
 
-#include <string.h>  // memcpy
+#include <inttypes.h>  // PRIu32
+#include <stdio.h>     // printf
+#include <string.h>    // strlen
 
 #include "ch32v003fun.h"
+
+// Timers for LED_MATRIX_TIMER
+#define LED_TIMER_SYSTICK 0  // SysTick runs the LED matrix
+#define LED_TIMER_TIM1    1  // TIM1 compare channel 1 runs the LED matrix, SysTick counts milliseconds
+#define LED_TIMER_TIM2    2  // TIM2 compare channel 1 runs the LED matrix, SysTick counts milliseconds
+#define LED_TIMER_DMA     3  // TIM1 and TIM2 trigger DMA to refresh the LED matrix, SysTick counts milliseconds
+
+#if LED_MATRIX_TIMER != LED_TIMER_SYSTICK
+// The scan timer counts core clock cycles over its whole 16-bit range.
+#define GPIO_timer_prescaler  0
+#define GPIO_timer_resolution 0xFFFF
+#endif
+
 #include "ch32v003_GPIO_branchless.h"
+#include "led_math.h"
+
+// Bit definitions for systick regs
+#define SYSTICK_SR_CNTIF   (1 << 0)
+#define SYSTICK_CTLR_STE   (1 << 0)
+#define SYSTICK_CTLR_STIE  (1 << 1)
+#define SYSTICK_CTLR_STCLK (1 << 2)
+#define SYSTICK_CTLR_STRE  (1 << 3)
+#define SYSTICK_CTLR_SWIE  (1 << 31)
+
+#define LED_MATRIX_SIZE (LED_MATRIX_NUM_PINS * (LED_MATRIX_NUM_PINS - 1))
+#define LED_PWM_CYCLES  (1 << LED_MATRIX_PWM_BITS)
+
+#define LED_FOR_EACH_LED(f)                                                                                \
+    f(0), f(1), f(2), f(3), f(4), f(5), f(6), f(7), f(8), f(9), f(10), f(11), f(12), f(13), f(14), f(15), \
+        f(16), f(17), f(18), f(19), f(20), f(21), f(22), f(23), f(24), f(25), f(26), f(27), f(28), f(29)
+
+// PWM engines for LED_MATRIX_PWM
+#define LED_PWM_LINEAR 0  // LED_PWM_CYCLES ticks per slot, an interrupt per tick
+#define LED_PWM_BAM    1  // Bit-angle modulation, an interrupt per bit of LED_MATRIX_PWM_BITS
+#define LED_PWM_EVENT  2  // LED_PWM_CYCLES ticks per slot, an interrupt only when an LED changes state
+
+// A scan slot lights LED_SLOT_COLUMNS consecutive LEDs of a row, every slot is shown once a frame.
+#if LED_MATRIX_SCAN_ROWS
+// One row at a time, at 104Hz and 16 cycles, 104 x 6 x 16 = 10,000 ticks per second
+#define LED_SLOT_COLUMNS     (LED_MATRIX_NUM_PINS - 1)
+#define LED_FOR_EACH_SLOT(f) f(0), f(1), f(2), f(3), f(4), f(5)
+#else
+// One LED at a time, at 104Hz and 16 cycles, 104 x 30 x 16 = 50,000 ticks per second
+#define LED_SLOT_COLUMNS 1
+#define LED_FOR_EACH_SLOT(f)                                                                           \
+    f(0), f(1), f(2), f(3), f(4), f(5), f(6), f(7), f(8), f(9), f(10), f(11), f(12), f(13), f(14), f(15), \
+        f(16), f(17), f(18), f(19), f(20), f(21), f(22), f(23), f(24), f(25), f(26), f(27), f(28), f(29)
+#endif
+#define LED_SLOTS_PER_ROW ((LED_MATRIX_NUM_PINS - 1) / LED_SLOT_COLUMNS)
+#define LED_SLOTS         (LED_MATRIX_NUM_PINS * LED_SLOTS_PER_ROW)
+
+// Cycles of a slot at LED_MATRIX_REFRESH_HZ, and of a tick of the linear PWM
+#define LED_SLOT_PERIOD_CYCLES (FUNCONF_SYSTEM_CORE_CLOCK / (LED_MATRIX_REFRESH_HZ * LED_SLOTS))
+#define LED_TICK_CYCLES        (LED_SLOT_PERIOD_CYCLES / LED_PWM_CYCLES)
+
+// Row pin and column index of the first LED of slot s
+#define LED_SLOT_ROW(s)   ((s) / LED_SLOTS_PER_ROW)
+#define LED_SLOT_FIRST(s) (((s) % LED_SLOTS_PER_ROW) * LED_SLOT_COLUMNS)
+
+// Dark slot skipping for LED_MATRIX_SKIP_DARK
+#define LED_SKIP_DARK_OFF        0  // Scan every slot
+#define LED_SKIP_DARK_FRAME      1  // Scan only lit slots, stretched to fill the frame, brighter when few are lit
+#define LED_SKIP_DARK_BRIGHTNESS 2  // Scan only lit slots, then stay idle for the rest of the frame
+
+#if LED_MATRIX_PWM == LED_PWM_BAM
+// Bit i of the duty cycle lights the LED for (LED_BAM_UNIT_CYCLES << i), the bits of a slot add up to a slot period.
+#define LED_PWM_MAX         ((1 << LED_MATRIX_PWM_BITS) - 1)
+#define LED_BAM_UNIT_CYCLES (LED_SLOT_PERIOD_CYCLES / LED_PWM_MAX)
+#else
+#define LED_PWM_MAX LED_PWM_CYCLES
+#endif
+
+// Brightest duty cycle the frame buffers hold. With LED_MATRIX_PACKED a duty cycle is a nibble, so the linear and
+// event PWM at 4 bits keep an LED on for at most 15 of the 16 ticks.
+#if LED_MATRIX_PACKED && LED_PWM_MAX > 15
+#define LED_DUTY_MAX 15
+#else
+#define LED_DUTY_MAX LED_PWM_MAX
+#endif
+
+// The shortest step, a tick of the linear PWM or the least significant bit of BAM, and a whole slot.
+#if LED_MATRIX_PWM == LED_PWM_BAM
+#define LED_UNIT_CYCLES LED_BAM_UNIT_CYCLES
+#else
+#define LED_UNIT_CYCLES LED_TICK_CYCLES
+#endif
+#define LED_SLOT_CYCLES  (LED_UNIT_CYCLES * LED_PWM_MAX)
+#define LED_FRAME_CYCLES (LED_SLOT_CYCLES * LED_SLOTS)
+
+// With variable step lengths, steps shorter than this are waited out in the ISR, the interrupt entry and exit would
+// take longer.
+#define LED_MIN_IRQ_CYCLES 200
+
+// Duty cycle of the perceived brightness v, 0 to 255. v is taken as the CIE 1931 lightness L* = v * 100 / 255, which
+// is converted to the relative luminance Y and scaled to LED_DUTY_MAX. Lit LEDs get at least a duty cycle of 1.
+#define LED_GAMMA_L(v) ((v) * 100.0 / 255)
+#define LED_GAMMA_C(l) (((l) + 16) / 116)
+#define LED_GAMMA_Y(l) ((l) <= 8 ? (l) / 903.3 : LED_GAMMA_C(l) * LED_GAMMA_C(l) * LED_GAMMA_C(l))
+#define LED_GAMMA_D(v) (LED_GAMMA_Y(LED_GAMMA_L(v)) * LED_DUTY_MAX + 0.5)
+#define LED_GAMMA(v)   ((v) == 0 ? 0 : LED_GAMMA_D(v) < 1 ? 1 : (uint8_t)LED_GAMMA_D(v))
+#define LED_GAMMA4(v)  LED_GAMMA(v), LED_GAMMA((v) + 1), LED_GAMMA((v) + 2), LED_GAMMA((v) + 3)
+#define LED_GAMMA16(v) LED_GAMMA4(v), LED_GAMMA4((v) + 4), LED_GAMMA4((v) + 8), LED_GAMMA4((v) + 12)
+#define LED_GAMMA64(v) LED_GAMMA16(v), LED_GAMMA16((v) + 16), LED_GAMMA16((v) + 32), LED_GAMMA16((v) + 48)
+
+// Mounting orientations for LED_MATRIX_ORIENTATION, the board turned clockwise as seen from the front
+#define LED_ORIENT_0   0
+#define LED_ORIENT_90  1
+#define LED_ORIENT_180 2
+#define LED_ORIENT_270 3
+
+// The matrix is LED_MATRIX_COLUMNS x LED_MATRIX_ROWS LEDs, LED i is column i % 5 of row i / 5, as the font is laid out.
+// Pixel (x, y) counts from the top left LED as the board is mounted, LED_MATRIX_WIDTH x LED_MATRIX_HEIGHT pixels.
+#define LED_MATRIX_COLUMNS (LED_MATRIX_NUM_PINS - 1)
+#define LED_MATRIX_ROWS    LED_MATRIX_NUM_PINS
+#if LED_MATRIX_ORIENTATION == LED_ORIENT_0
+#define LED_MATRIX_WIDTH  LED_MATRIX_COLUMNS
+#define LED_MATRIX_HEIGHT LED_MATRIX_ROWS
+#define LED_PIXEL_COLUMN(x, y) (x)
+#define LED_PIXEL_ROW(x, y)    (y)
+#elif LED_MATRIX_ORIENTATION == LED_ORIENT_90
+#define LED_MATRIX_WIDTH  LED_MATRIX_ROWS
+#define LED_MATRIX_HEIGHT LED_MATRIX_COLUMNS
+#define LED_PIXEL_COLUMN(x, y) (y)
+#define LED_PIXEL_ROW(x, y)    (LED_MATRIX_ROWS - 1 - (x))
+#elif LED_MATRIX_ORIENTATION == LED_ORIENT_180
+#define LED_MATRIX_WIDTH  LED_MATRIX_COLUMNS
+#define LED_MATRIX_HEIGHT LED_MATRIX_ROWS
+#define LED_PIXEL_COLUMN(x, y) (LED_MATRIX_COLUMNS - 1 - (x))
+#define LED_PIXEL_ROW(x, y)    (LED_MATRIX_ROWS - 1 - (y))
+#elif LED_MATRIX_ORIENTATION == LED_ORIENT_270
+#define LED_MATRIX_WIDTH  LED_MATRIX_ROWS
+#define LED_MATRIX_HEIGHT LED_MATRIX_COLUMNS
+#define LED_PIXEL_COLUMN(x, y) (LED_MATRIX_COLUMNS - 1 - (y))
+#define LED_PIXEL_ROW(x, y)    (x)
+#else
+#error "Unknown LED_MATRIX_ORIENTATION"
+#endif
+
+// LED of pixel p = y * LED_MATRIX_WIDTH + x, mirrored left to right after the rotation with LED_MATRIX_MIRROR
+#define LED_PIXEL_X(p)   (LED_MATRIX_MIRROR ? LED_MATRIX_WIDTH - 1 - (p) % LED_MATRIX_WIDTH : (p) % LED_MATRIX_WIDTH)
+#define LED_PIXEL_Y(p)   ((p) / LED_MATRIX_WIDTH)
+#define LED_PIXEL_LED(p) (LED_PIXEL_ROW(LED_PIXEL_X(p), LED_PIXEL_Y(p)) * LED_MATRIX_COLUMNS + \
+                          LED_PIXEL_COLUMN(LED_PIXEL_X(p), LED_PIXEL_Y(p)))
+
+// Estimated ISR load, checked against LED_MATRIX_ISR_BUDGET. The cycles of an interrupt are rough figures for rv32ec:
+// entry and exit with the compare update, plus the work for each LED of the slot. They are counted by hand from the
+// code paths, not measured, LED_MATRIX_PROFILE measures the ISR on the chip to check them against.
+#if LED_MATRIX_PROFILE
+// The counters of LED_MATRIX_PROFILE add about 30 cycles
+#define LED_IRQ_ENTRY_CYCLES 70
+#else
+#define LED_IRQ_ENTRY_CYCLES 40
+#endif
+#if LED_MATRIX_PORT_TABLES
+#define LED_IRQ_LED_CYCLES 12
+#else
+#define LED_IRQ_LED_CYCLES 40
+#endif
+#define LED_IRQ_CYCLES (LED_IRQ_ENTRY_CYCLES + LED_SLOT_COLUMNS * LED_IRQ_LED_CYCLES)
+
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#define LED_ISR_SLOT_CYCLES 0
+#elif LED_MATRIX_PWM == LED_PWM_BAM
+// An interrupt per bit, the bits shorter than LED_MIN_IRQ_CYCLES are waited out and add up to less than twice that.
+#define LED_ISR_SLOT_CYCLES (LED_MATRIX_PWM_BITS * LED_IRQ_CYCLES + 2 * LED_MIN_IRQ_CYCLES)
+#elif LED_MATRIX_PWM == LED_PWM_EVENT
+// A step per distinct duty cycle plus the slot start, each may be waited out.
+#define LED_ISR_SLOT_CYCLES ((LED_SLOT_COLUMNS + 1) * (LED_IRQ_CYCLES + LED_MIN_IRQ_CYCLES))
+#else
+#define LED_ISR_SLOT_CYCLES (LED_PWM_CYCLES * LED_IRQ_CYCLES)
+#endif
+#define LED_ISR_CYCLES_PER_SECOND (LED_ISR_SLOT_CYCLES * LED_SLOTS * LED_MATRIX_REFRESH_HZ)
+
+_Static_assert(LED_MATRIX_NUM_PINS == 6, "The pins, font and effects are laid out for 6 pins");
+_Static_assert(LED_MATRIX_PWM_BITS <= ((LED_MATRIX_PWM == LED_PWM_BAM) ? 8 : 7), "Duty cycles are 8 bits");
+_Static_assert(!LED_MATRIX_PACKED || LED_MATRIX_PWM_BITS <= 4, "LED_MATRIX_PACKED holds duty cycles up to 15");
+_Static_assert(!LED_MATRIX_SCROLL || (!LED_MATRIX_SKIP_DARK && LED_MATRIX_TIMER != LED_TIMER_DMA),
+               "LED_MATRIX_SCROLL needs the ISR scan of every slot, the skip list and the DMA table are laid out when "
+               "the frame is updated");
+_Static_assert(LED_MATRIX_MARQUEE_COLUMNS <= 255, "Marquee columns are counted in a byte");
+_Static_assert(!LED_MATRIX_QUEUE || (LED_MATRIX_QUEUE >= 2 && LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_OFF &&
+                                     LED_MATRIX_TIMER != LED_TIMER_DMA),
+               "LED_MATRIX_QUEUE needs 2 frames or more and the ISR scan of every slot");
+_Static_assert(LED_UNIT_CYCLES >= 1, "LED_MATRIX_REFRESH_HZ and LED_MATRIX_PWM_BITS too high for the core clock");
+_Static_assert((unsigned long long)LED_ISR_CYCLES_PER_SECOND * 100 <=
+                   (unsigned long long)FUNCONF_SYSTEM_CORE_CLOCK * LED_MATRIX_ISR_BUDGET,
+               "LED matrix ISR over LED_MATRIX_ISR_BUDGET, lower LED_MATRIX_REFRESH_HZ or LED_MATRIX_PWM_BITS");
+
+#define LED_PIN_0 GPIOv_from_PORT_PIN(GPIO_port_C, 1)  // IO1
+#define LED_PIN_1 GPIOv_from_PORT_PIN(GPIO_port_C, 2)  // IO2
+#define LED_PIN_2 GPIOv_from_PORT_PIN(GPIO_port_C, 4)  // IO3
+#define LED_PIN_3 GPIOv_from_PORT_PIN(GPIO_port_D, 5)  // IO4
+#define LED_PIN_4 GPIOv_from_PORT_PIN(GPIO_port_A, 1)  // IO5
+#define LED_PIN_5 GPIOv_from_PORT_PIN(GPIO_port_A, 2)  // IO6
+
+uint8_t pins[LED_MATRIX_NUM_PINS] = {LED_PIN_0, LED_PIN_1, LED_PIN_2, LED_PIN_3, LED_PIN_4, LED_PIN_5};
+
+// Read-only data kept in the .assets section of flash and read in place, not copied to RAM at reset
+#define LED_ASSET __attribute__((section(".assets")))
+
+// Encodings of the 5x6 pixel font in led_font.h, which tools/font_compiler writes from fonts/led_font.txt
+//  - LED_FONT_FIXED:   font[], a word per glyph, bit y * 5 + x lights pixel (x, y) of the cell.
+//  - LED_FONT_COLUMNS: font_columns[], the lit columns of every glyph, bit y lights line y. Glyph i takes the columns
+//                      from LED_FONT_OFFSET(font_offsets[i]) up to the offset of glyph i + 1, and its first column is
+//                      column LED_FONT_LEFT(font_offsets[i]) of the cell.
+// Code points LED_FONT_FIRST to LED_FONT_LAST are glyphs 0 on, the other code points are looked up in blocks of 32.
+// Code point cp is in block cp >> 5, led_glyph_map holds the row of led_glyph_blocks plus 1 for the blocks that have
+// glyphs, and the row holds the glyph plus 1 for every code point of the block. 0 is none in both.
+#define LED_FONT_FIXED          0
+#define LED_FONT_COLUMNS        1
+#define LED_FONT_OFFSET(v)      ((v) & 0x1fff)
+#define LED_FONT_LEFT(v)        ((v) >> 13)
+#define LED_FONT_BLANK_COLUMNS  2  // Marquee columns of a blank glyph
+#define LED_GLYPH_AT(cp, glyph) [(cp) & 0x1f] = (glyph) + 1
+#define LED_GLYPH_NONE          0xff
+#include "led_font.h"
+
+// Effects, brightness 0 to 255
+static const uint8_t effects[][LED_MATRIX_SIZE] LED_ASSET = {
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 255},          // Dot
+    {255, 204, 153, 102, 51, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},  // Snake
+    {0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0, 0, 0, 0, 255},  // Line
+    {0, 64, 128, 192, 255, 0, 64, 128, 192, 255, 0, 64, 128, 192, 255,
+     0, 64, 128, 192, 255, 0, 64, 128, 192, 255, 0, 64, 128, 192, 255},  // Diagonal wave
+};
+
+#define LED_EFFECT_DOT   0
+#define LED_EFFECT_SNAKE 1
+#define LED_EFFECT_LINE  2
+#define LED_EFFECT_WAVE  3
+#define LED_EFFECTS      (sizeof(effects) / sizeof(effects[0]))
+
+// Animation streams decoded by led_stream_next(), a byte stream of keyframes and delta frames of 4-bit levels
+#define LED_STREAM_SKIP    0x00  // 00nnnnnn: n + 1 pixels keep their level
+#define LED_STREAM_LITERAL 0x40  // 01nnnnnn: n + 1 levels follow, two a byte, the first one in the low nibble
+#define LED_STREAM_RUN     0x80  // 1llllnnn: n + 1 pixels of level l
+#define LED_STREAM_RECOLOR 0x80  // Frame header flag, runs only set the pixels lit in the frame before
+#define LED_STREAM_HOLD    0x7f  // Frame header, refresh frames to show the frame for
+#include "led_streams.h"
+
+// Asset table, the flash address, item size and item count of every asset. The accessors below read the assets
+// through it, LED_ASSET_DATA() gives the address of asset id as a pointer of the given type.
+#define LED_ASSET_FONT         0  // font[] or font_columns[]
+#define LED_ASSET_FONT_OFFSETS 1  // font_offsets[] of LED_FONT_COLUMNS
+#define LED_ASSET_GLYPH_MAP    2
+#define LED_ASSET_GLYPH_BLOCKS 3
+#define LED_ASSET_EFFECTS      4
+#define LED_ASSET_STREAMS      5
+#define LED_ASSETS             6
+
+static const struct led_asset
+{
+    const void *data;
+    uint16_t    size;
+    uint16_t    count;
+} led_assets[LED_ASSETS] LED_ASSET = {
+#if LED_FONT_ENCODING == LED_FONT_FIXED
+    [LED_ASSET_FONT]         = {font, sizeof(font[0]), LED_FONT_GLYPHS},
+#else
+    [LED_ASSET_FONT]         = {font_columns, sizeof(font_columns[0]), sizeof(font_columns)},
+    [LED_ASSET_FONT_OFFSETS] = {font_offsets, sizeof(font_offsets[0]), LED_FONT_GLYPHS + 1},
+#endif
+    [LED_ASSET_GLYPH_MAP]    = {led_glyph_map, sizeof(led_glyph_map[0]), LED_GLYPH_BLOCKS},
+    [LED_ASSET_GLYPH_BLOCKS] = {led_glyph_blocks, sizeof(led_glyph_blocks[0]),
+                                sizeof(led_glyph_blocks) / sizeof(led_glyph_blocks[0])},
+    [LED_ASSET_EFFECTS]      = {effects, sizeof(effects[0]), LED_EFFECTS},
+    [LED_ASSET_STREAMS]      = {led_streams, sizeof(led_streams[0]), LED_STREAMS},
+};
+
+#define LED_ASSET_DATA(id, type) ((type)led_assets[id].data)
+
+// Glyph index of code point cp, LED_GLYPH_NONE if the font does not have it. At most two table reads whatever the
+// code point, no search.
+static inline uint8_t led_glyph_index(uint16_t cp)
+{
+    if (cp >= LED_FONT_FIRST && cp <= LED_FONT_LAST)
+    {
+        return cp - LED_FONT_FIRST;
+    }
+
+    const uint8_t *map = LED_ASSET_DATA(LED_ASSET_GLYPH_MAP, const uint8_t *);
+    const uint8_t(*blocks)[32] = LED_ASSET_DATA(LED_ASSET_GLYPH_BLOCKS, const uint8_t(*)[32]);
+    uint16_t block             = cp >> 5;
+    uint8_t  row               = (block < led_assets[LED_ASSET_GLYPH_MAP].count) ? map[block] : 0;
+    return (row != 0) ? blocks[row - 1][cp & 0x1f] - 1 : LED_GLYPH_NONE;
+}
+
+// Glyph of code point cp, blank if the font does not have it
+static inline uint32_t led_glyph(uint16_t cp)
+{
+    uint8_t i = led_glyph_index(cp);
+    if (i == LED_GLYPH_NONE)
+    {
+        return 0;
+    }
+#if LED_FONT_ENCODING == LED_FONT_FIXED
+    return LED_ASSET_DATA(LED_ASSET_FONT, const uint32_t *)[i];
+#else
+    const uint16_t *offsets = LED_ASSET_DATA(LED_ASSET_FONT_OFFSETS, const uint16_t *);
+    const uint8_t  *columns = LED_ASSET_DATA(LED_ASSET_FONT, const uint8_t *);
+    uint32_t        glyph   = 0;
+    uint16_t        from    = offsets[i];
+    uint8_t         x       = LED_FONT_LEFT(from);
+    for (uint16_t c = LED_FONT_OFFSET(from); c < LED_FONT_OFFSET(offsets[i + 1]); c++, x++)
+    {
+        uint8_t column = columns[c];
+        for (uint8_t bit = x; column != 0; bit += LED_MATRIX_COLUMNS, column >>= 1)
+        {
+            glyph |= (uint32_t)(column & 0x01) << bit;
+        }
+    }
+    return glyph;
+#endif
+}
+
+// Lit columns of glyph i for the marquee, bit y lights line y, LED_FONT_BLANK_COLUMNS blank ones for a blank glyph.
+// Returns the number of columns.
+static uint8_t led_glyph_columns(uint8_t i, uint8_t *columns)
+{
+#if LED_FONT_ENCODING == LED_FONT_FIXED
+    uint32_t glyph                    = LED_ASSET_DATA(LED_ASSET_FONT, const uint32_t *)[i];
+    uint8_t  cell[LED_MATRIX_COLUMNS] = {0};
+    for (uint8_t y = 0; y < LED_MATRIX_ROWS; y++)
+    {
+        for (uint8_t x = 0; x < LED_MATRIX_COLUMNS; x++, glyph >>= 1)
+        {
+            cell[x] |= (glyph & 0x01) << y;
+        }
+    }
+
+    uint8_t first = 0, last = LED_MATRIX_COLUMNS;
+    while (first < last && cell[first] == 0)
+    {
+        first++;
+    }
+    while (last > first && cell[last - 1] == 0)
+    {
+        last--;
+    }
+    if (first == last)
+    {
+        memset(columns, 0, LED_FONT_BLANK_COLUMNS);
+        return LED_FONT_BLANK_COLUMNS;
+    }
+    memcpy(columns, &cell[first], last - first);
+    return last - first;
+#else
+    const uint16_t *offsets = LED_ASSET_DATA(LED_ASSET_FONT_OFFSETS, const uint16_t *);
+    uint16_t        from    = LED_FONT_OFFSET(offsets[i]);
+    uint8_t         n       = LED_FONT_OFFSET(offsets[i + 1]) - from;
+    memcpy(columns, LED_ASSET_DATA(LED_ASSET_FONT, const uint8_t *) + from, n);
+    return n;
+#endif
+}
+
+// Next code point of UTF-8 text, moving text past it. A malformed sequence gives U+FFFD and skips the bytes read, as
+// do overlong encodings and UTF-16 surrogates. Code points past U+FFFF give U+FFFD, which the font does not have.
+static uint16_t led_utf8_next(const char **text)
+{
+    const uint8_t *s   = (const uint8_t *)*text;
+    uint32_t       cp  = *s++;
+    uint32_t       min = 0;  // Smallest code point of the sequence length
+    uint8_t        n   = 0;
+    if (cp >= 0xf8 || (cp >= 0x80 && cp < 0xc0))
+    {
+        cp = 0xfffd;  // Not a lead byte
+    }
+    else if (cp >= 0xf0)
+    {
+        cp &= 0x07;
+        n   = 3;
+        min = 0x10000;
+    }
+    else if (cp >= 0xe0)
+    {
+        cp &= 0x0f;
+        n   = 2;
+        min = 0x800;
+    }
+    else if (cp >= 0xc0)
+    {
+        cp &= 0x1f;
+        n   = 1;
+        min = 0x80;
+    }
+
+    for (; n != 0; n--, s++)
+    {
+        if ((*s & 0xc0) != 0x80)
+        {
+            cp = 0xfffd;
+            break;
+        }
+        cp = (cp << 6) | (*s & 0x3f);
+    }
+    *text = (const char *)s;
+    return (cp < min || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0xffff) ? 0xfffd : cp;
+}
+
+// Brightness of the LEDs in effect e, e below LED_EFFECTS
+static inline const uint8_t *led_effect(uint8_t e)
+{
+    return LED_ASSET_DATA(LED_ASSET_EFFECTS, const uint8_t(*)[LED_MATRIX_SIZE])[e];
+}
+
+// Duty cycle of every brightness, built at compile time
+static const uint8_t led_gamma[256] = {
+    LED_GAMMA64(0),
+    LED_GAMMA64(64),
+    LED_GAMMA64(128),
+    LED_GAMMA64(192),
+};
+
+// LED of every pixel, row by row, built at compile time for LED_MATRIX_ORIENTATION and LED_MATRIX_MIRROR
+static const uint8_t led_pixels[LED_MATRIX_SIZE] = {LED_FOR_EACH_LED(LED_PIXEL_LED)};
+
+#if LED_MATRIX_PACKED
+// Two LEDs a byte, the even LED in the low nibble
+#define LED_FRAME_BYTES ((LED_MATRIX_SIZE + 1) / 2)
+
+static inline uint8_t led_get_duty(const uint8_t *frame, uint8_t i)
+{
+    uint8_t duty = frame[i >> 1];
+    return (i & 0x01) ? duty >> 4 : duty & 0x0f;
+}
+
+static inline void led_set_duty(uint8_t *frame, uint8_t i, uint8_t duty)
+{
+    uint8_t *byte = &frame[i >> 1];
+    *byte         = (i & 0x01) ? (*byte & 0x0f) | (duty << 4) : (*byte & 0xf0) | duty;
+}
+#else
+#define LED_FRAME_BYTES LED_MATRIX_SIZE
+
+static inline uint8_t led_get_duty(const uint8_t *frame, uint8_t i)
+{
+    return frame[i];
+}
+
+static inline void led_set_duty(uint8_t *frame, uint8_t i, uint8_t duty)
+{
+    frame[i] = duty;
+}
+#endif
+
+// PWM duty cycles of LEDs, 0 to LED_DUTY_MAX, read and written with led_get_duty() and led_set_duty(). The ISR scans
+// the front buffer while led_duty_cycles points to the back buffer, the buffers are swapped at the start of a frame
+// after led_matrix_update(). The DMA refresh scans its own table, so there is a single buffer.
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#define LED_FRAME_BUFFERS 1
+#else
+#define LED_FRAME_BUFFERS 2
+#endif
+static uint8_t led_frame_buffers[LED_FRAME_BUFFERS][LED_FRAME_BYTES];
+uint8_t *volatile led_duty_cycles = led_frame_buffers[LED_FRAME_BUFFERS - 1];
+#if LED_FRAME_BUFFERS == 2
+static uint8_t *volatile led_front = led_frame_buffers[0];
+#else
+#define led_front led_duty_cycles
+#endif
+
+static inline uint32_t led_matrix_run();
+
+#define BOARD 0
+
+#if LED_MATRIX_PROFILE
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#error "LED_MATRIX_PROFILE measures the matrix ISR, the DMA refresh has none"
+#endif
+#if !FUNCONF_USE_DEBUGPRINTF
+#error "LED_MATRIX_PROFILE reports over the debug link, set FUNCONF_USE_DEBUGPRINTF"
+#endif
+
+// Histogram of the ISR cycles, bins of 64 cycles, the last bin takes all longer runs.
+#define LED_PROFILE_BINS      8
+#define LED_PROFILE_BIN_SHIFT 6
+
+// ISR counters since the last report. The cycles are SysTick->CNT from the first statement of the ISR to the last,
+// the register save and restore of the interrupt entry and exit are not included.
+struct led_profile
+{
+    uint32_t start;   // SysTick->CNT at the start of the window
+    uint32_t irqs;    // Interrupts
+    uint32_t cycles;  // Cycles in the ISR
+    uint32_t min;
+    uint32_t max;
+    uint32_t missed;  // Compares set to a time already passed, the timer has to wrap around to trigger again
+    uint32_t histogram[LED_PROFILE_BINS];
+};
+
+static volatile struct led_profile led_profile = {.min = UINT32_MAX};
+
+// Set by a 'p' (report) or an 'm' (math benchmark) from the debug link, run by led_profile_poll().
+static volatile uint8_t led_profile_requested;
+
+// Record an ISR run, start is SysTick->CNT on entry, missed is 1 if the new compare is already behind the counter.
+static inline void led_profile_isr(uint32_t start, uint32_t missed)
+{
+    uint32_t cycles = SysTick->CNT - start;
+    uint32_t bin    = cycles >> LED_PROFILE_BIN_SHIFT;
+
+    led_profile.irqs++;
+    led_profile.cycles += cycles;
+    led_profile.missed += missed;
+    if (cycles < led_profile.min)
+    {
+        led_profile.min = cycles;
+    }
+    if (cycles > led_profile.max)
+    {
+        led_profile.max = cycles;
+    }
+    led_profile.histogram[bin < LED_PROFILE_BINS ? bin : LED_PROFILE_BINS - 1]++;
+}
+
+#define LED_PROFILE_START()     uint32_t led_profile_start = SysTick->CNT
+#define LED_PROFILE_END(missed) led_profile_isr(led_profile_start, missed)
+
+void handle_debug_input(int numbytes, uint8_t *data)
+{
+    if (numbytes > 0 && (data[0] == 'p' || data[0] == 'm'))
+    {
+        led_profile_requested = data[0];
+    }
+}
+
+// Operands of led_math_bench(), volatile so the arithmetic is neither folded nor hoisted
+static volatile uint8_t led_bench_n = 0x5a;
+static volatile uint8_t led_bench_sink;
+
+// Cycles of 256 runs of expr of x, n and t, with 1 <= n <= 255 and t running from 0 to 255
+#define LED_BENCH(expr)                                                                       \
+    ({                                                                                        \
+        uint32_t start = SysTick->CNT;                                                        \
+        for (uint16_t led_bench_i = 0; led_bench_i < 256; led_bench_i++)                      \
+        {                                                                                     \
+            uint8_t x = led_bench_i, n = (led_bench_n ^ led_bench_i) | 0x01, t = led_bench_i; \
+            (void)t;                                                                          \
+            led_bench_sink = (expr);                                                          \
+        }                                                                                     \
+        SysTick->CNT - start;                                                                 \
+    })
+
+// Time the led_math.h functions against plain arithmetic, which calls __mulsi3, __divsi3 and __modsi3 of libgcc. The
+// figures include the loop, as the empty loop shows. Interrupts are off meanwhile, the matrix stops for a few ms.
+static void led_math_bench()
+{
+    static const char *names[] = {"loop", "mul", "div", "mod", "scale", "lerp"};
+    uint32_t           naive[6], kit[6];
+
+    __disable_irq();
+    naive[0] = kit[0] = LED_BENCH(x ^ n);
+    naive[1]          = LED_BENCH(x * n);
+    kit[1]            = LED_BENCH(led_mul8(x, n));
+    naive[2]          = LED_BENCH(x / n);
+    kit[2]            = LED_BENCH(led_div8(x, n));
+    naive[3]          = LED_BENCH(x % n);
+    kit[3]            = LED_BENCH(led_mod8(x, n));
+    naive[4]          = LED_BENCH(x * (n + 1) >> 8);
+    kit[4]            = LED_BENCH(led_scale8(x, n));
+    naive[5]          = LED_BENCH(x + (n - x) * (t + 1) / 256);
+    kit[5]            = LED_BENCH(led_lerp8(x, n, t));
+    __enable_irq();
+
+    printf("math cycles per op, libgcc / led_math.h:");
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        printf(" %s %" PRIu32 "/%" PRIu32, names[i], naive[i] >> 8, kit[i] >> 8);
+    }
+    printf("\n");
+}
+
+// Check the debug link for a report or benchmark request, call it from the main loop. The report covers the time since
+// the last one, the counters start over after every report. The window must be shorter than a SysTick wrap, 536s at
+// 8MHz.
+void led_profile_poll()
+{
+    poll_input();
+    uint8_t request       = led_profile_requested;
+    led_profile_requested = 0;
+    if (request == 'm')
+    {
+        led_math_bench();
+    }
+    if (request != 'p')
+    {
+        return;
+    }
+
+    // Take the counters and start a new window
+    struct led_profile p;
+    __disable_irq();
+    p                 = *(struct led_profile *)&led_profile;
+    uint32_t now      = SysTick->CNT;
+    led_profile       = (struct led_profile){.start = now, .min = UINT32_MAX};
+    __enable_irq();
+
+    uint32_t elapsed = now - p.start;
+    uint32_t load    = p.cycles / (elapsed / 1000 + 1);  // Per mille
+    printf("isr %" PRIu32 " irqs in %" PRIu32 " cycles, min %" PRIu32 ", mean %" PRIu32 ", max %" PRIu32
+           ", missed %" PRIu32 ", load %" PRIu32 ".%" PRIu32 "%%\n",
+           p.irqs, elapsed, p.irqs ? p.min : 0, p.irqs ? p.cycles / p.irqs : 0, p.max, p.missed, load / 10, load % 10);
+    printf("cycles");
+    for (uint8_t i = 0; i < LED_PROFILE_BINS; i++)
+    {
+        printf(" %u%s:%" PRIu32, i << LED_PROFILE_BIN_SHIFT, i == LED_PROFILE_BINS - 1 ? "+" : "", p.histogram[i]);
+    }
+    printf("\n");
+}
+#else
+#define LED_PROFILE_START()
+#define LED_PROFILE_END(missed)
+
+static inline void led_profile_poll() {}
+#endif
+
+#if LED_MATRIX_TIMER == LED_TIMER_SYSTICK
+// Start up the SysTick IRQ
+void systick_init(void)
+{
+    // Disable default SysTick behavior
+    SysTick->CTLR = 0;
+
+    // Enable the SysTick IRQ
+    NVIC_EnableIRQ(SysTicK_IRQn);
+
+    // Set the tick interval
+    SysTick->CMP = LED_TICK_CYCLES - 1;
+
+    // Start at zero
+    SysTick->CNT = 0;
+
+    // Enable SysTick counter, IRQ, HCLK/1
+    SysTick->CTLR = SYSTICK_CTLR_STE | SYSTICK_CTLR_STIE | SYSTICK_CTLR_STCLK;
+}
+
+// SysTick ISR runs the LED matrix
+__attribute__((interrupt)) void SysTick_Handler(void)
+{
+    LED_PROFILE_START();
+
+    // Clear IRQ
+    SysTick->SR = 0;
+
+    // Move the compare further ahead in time by the length of the step just started. as a warning, if more than
+    // this length of time passes before triggering, you may miss your interrupt.
+#if LED_MATRIX_PWM != LED_PWM_LINEAR
+    // Short steps are not worth another interrupt, wait them out here.
+    uint32_t next = SysTick->CMP + led_matrix_run();
+    while ((int32_t)(next - SysTick->CNT) < LED_MIN_IRQ_CYCLES)
+    {
+        while ((int32_t)(SysTick->CNT - next) < 0)
+        {
+        }
+        next += led_matrix_run();
+    }
+    SysTick->CMP = next;
+#else
+    SysTick->CMP += led_matrix_run();
+#endif
+
+    LED_PROFILE_END((int32_t)(SysTick->CMP - SysTick->CNT) <= 0);
+}
+#else
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#elif LED_MATRIX_TIMER == LED_TIMER_TIM1
+#define LED_TIM            TIM1
+#define LED_TIM_IRQn       TIM1_CC_IRQn
+#define LED_TIM_IRQHandler TIM1_CC_IRQHandler
+#define LED_TIM_INIT       GPIO_tim1_init
+#else
+#define LED_TIM            TIM2
+#define LED_TIM_IRQn       TIM2_IRQn
+#define LED_TIM_IRQHandler TIM2_IRQHandler
+#define LED_TIM_INIT       GPIO_tim2_init
+#endif
+
+// Milliseconds since systick_init()
+volatile uint32_t systick_millis;
+
+// Start up the SysTick IRQ, it is free for timekeeping as a timer runs the LED matrix
+void systick_init(void)
+{
+    // Disable default SysTick behavior
+    SysTick->CTLR = 0;
+
+    // Enable the SysTick IRQ
+    NVIC_EnableIRQ(SysTicK_IRQn);
+
+    // Set the tick interval to 1ms
+    SysTick->CMP = DELAY_MS_TIME - 1;
+
+    // Start at zero
+    SysTick->CNT   = 0;
+    systick_millis = 0;
+
+    // Enable SysTick counter, IRQ, HCLK/1
+    SysTick->CTLR = SYSTICK_CTLR_STE | SYSTICK_CTLR_STIE | SYSTICK_CTLR_STCLK;
+}
+
+// SysTick ISR counts milliseconds
+__attribute__((interrupt)) void SysTick_Handler(void)
+{
+    SysTick->CMP += DELAY_MS_TIME;
+    SysTick->SR = 0;
+    systick_millis++;
+}
+
+#if LED_MATRIX_TIMER != LED_TIMER_DMA
+// The compare is 16 bits, longer steps are split into several interrupts. Half the range keeps the signed compare
+// of the counter against the compare value safe.
+#define LED_TIM_MAX_STEP 0x8000
+
+// Start up the timer running the LED matrix. It counts core clock cycles freely, compare channel 1 is moved ahead
+// by every step like the SysTick compare.
+static inline void led_timer_init()
+{
+    LED_TIM_INIT();
+
+    // Channel 1 as a frozen output compare without preload, so a new compare value takes effect at once.
+    LED_TIM->CHCTLR1 = 0;
+    LED_TIM->CH1CVR  = LED_TICK_CYCLES - 1;
+    LED_TIM->CNT     = 0;
+    LED_TIM->INTFR   = 0;
+    LED_TIM->DMAINTENR |= TIM_CC1IE;
+    NVIC_EnableIRQ(LED_TIM_IRQn);
+}
+
+// Cycles of the current step not programmed into the compare yet
+static uint32_t led_timer_left;
+
+// Timer ISR runs the LED matrix
+__attribute__((interrupt)) void LED_TIM_IRQHandler(void)
+{
+    LED_PROFILE_START();
+
+    // Clear IRQ
+    LED_TIM->INTFR = (uint16_t)~TIM_CC1IF;
+
+    uint16_t now    = LED_TIM->CH1CVR;
+    uint32_t cycles = led_timer_left;
+    if (cycles == 0)
+    {
+        cycles = led_matrix_run();
+#if LED_MATRIX_PWM != LED_PWM_LINEAR
+        // Short steps are not worth another interrupt, wait them out here.
+        while (cycles < LED_MIN_IRQ_CYCLES + (uint32_t)(uint16_t)(LED_TIM->CNT - now))
+        {
+            now += cycles;
+            while ((int16_t)(LED_TIM->CNT - now) < 0)
+            {
+            }
+            cycles = led_matrix_run();
+        }
+#endif
+    }
+
+    if (cycles > LED_TIM_MAX_STEP)
+    {
+        led_timer_left = cycles - LED_TIM_MAX_STEP;
+        cycles         = LED_TIM_MAX_STEP;
+    }
+    else
+    {
+        led_timer_left = 0;
+    }
+    LED_TIM->CH1CVR = (uint16_t)(now + cycles);
+
+    LED_PROFILE_END((int16_t)(LED_TIM->CH1CVR - LED_TIM->CNT) <= 0);
+}
+#endif
+#endif
+
+#if LED_MATRIX_PORT_TABLES
+// Precomputed port words, the ISR only stores them to CFGLR and BSHR of port A, C and D.
+//
+// The words are built at compile time from LED_PIN_n. For slot s and mask m (bit i = the i-th LED of the slot is
+// on), led_slot_cfglr[s][m][x] holds the CFGLR nibbles of all matrix pins on port x, led_slot_bshr[s][x] pulls up
+// the column pins and pulls down the row pin of slot s. Other pins keep the config in led_cfglr_base[x].
+#define LED_PORTS        3
+#define LED_PORT_INDEX(v) ((GPIOv_to_PORT(v) == GPIO_port_A) ? 0 : GPIOv_to_PORT(v) - 1)  // A, C, D => 0, 1, 2
+#define LED_CFG_OUT      (GPIO_Speed_10MHz | GPIO_CNF_OUT_PP)
+#define LED_CFG_FLOAT    (GPIO_Speed_In | GPIO_CNF_IN_FLOATING)
+
+// Row pin, first column and column index of pin p in slot s
+#define LED_COLUMN_INDEX(s, p) ((p) - ((p) > LED_SLOT_ROW(s)))
+#define LED_PIN_IN_SLOT(s, p)                                                                 \
+    ((p) != LED_SLOT_ROW(s) && LED_COLUMN_INDEX(s, p) >= LED_SLOT_FIRST(s) &&                 \
+     LED_COLUMN_INDEX(s, p) < LED_SLOT_FIRST(s) + LED_SLOT_COLUMNS)
+#define LED_PIN_ON(s, m, p) \
+    ((p) == LED_SLOT_ROW(s) || (LED_PIN_IN_SLOT(s, p) && ((((m) << LED_SLOT_FIRST(s)) >> LED_COLUMN_INDEX(s, p)) & 1)))
+
+#define LED_PIN_ON_PORT(x, p) (LED_PORT_INDEX(LED_PIN_##p) == (x))
+#define LED_PIN_CFG(x, p, on) \
+    (LED_PIN_ON_PORT(x, p) ? ((on) ? LED_CFG_OUT : LED_CFG_FLOAT) << (4 * GPIOv_to_PIN(LED_PIN_##p)) : 0)
+#define LED_PIN_BSHR(x, s, p)                                                                \
+    (!LED_PIN_ON_PORT(x, p)                ? 0                                                \
+     : (p) == LED_SLOT_ROW(s)              ? (1 << (16 + GPIOv_to_PIN(LED_PIN_##p)))          \
+     : LED_PIN_IN_SLOT(s, p)               ? (1 << GPIOv_to_PIN(LED_PIN_##p))                 \
+                                           : 0)
+
+#define LED_PIN_MASK(x, p) (LED_PIN_ON_PORT(x, p) ? 0xf << (4 * GPIOv_to_PIN(LED_PIN_##p)) : 0)
+#define LED_PORT_MASK(x)                                                                            \
+    (LED_PIN_MASK(x, 0) | LED_PIN_MASK(x, 1) | LED_PIN_MASK(x, 2) | LED_PIN_MASK(x, 3) | LED_PIN_MASK(x, 4) | \
+     LED_PIN_MASK(x, 5))
+#define LED_PORT_FLOAT(x)                                                                     \
+    (LED_PIN_CFG(x, 0, 0) | LED_PIN_CFG(x, 1, 0) | LED_PIN_CFG(x, 2, 0) | LED_PIN_CFG(x, 3, 0) | \
+     LED_PIN_CFG(x, 4, 0) | LED_PIN_CFG(x, 5, 0))
+#define LED_PORT_CFGLR(x, s, m)                                                                \
+    (LED_PIN_CFG(x, 0, LED_PIN_ON(s, m, 0)) | LED_PIN_CFG(x, 1, LED_PIN_ON(s, m, 1)) |          \
+     LED_PIN_CFG(x, 2, LED_PIN_ON(s, m, 2)) | LED_PIN_CFG(x, 3, LED_PIN_ON(s, m, 3)) |          \
+     LED_PIN_CFG(x, 4, LED_PIN_ON(s, m, 4)) | LED_PIN_CFG(x, 5, LED_PIN_ON(s, m, 5)))
+#define LED_PORT_BSHR(x, s)                                                                    \
+    (LED_PIN_BSHR(x, s, 0) | LED_PIN_BSHR(x, s, 1) | LED_PIN_BSHR(x, s, 2) | LED_PIN_BSHR(x, s, 3) | \
+     LED_PIN_BSHR(x, s, 4) | LED_PIN_BSHR(x, s, 5))
+
+#define LED_CFGLR(s, m) {LED_PORT_CFGLR(0, s, m), LED_PORT_CFGLR(1, s, m), LED_PORT_CFGLR(2, s, m)}
+#define LED_CFGLR_2(s, m)  LED_CFGLR(s, m), LED_CFGLR(s, (m) + 1)
+#define LED_CFGLR_4(s, m)  LED_CFGLR_2(s, m), LED_CFGLR_2(s, (m) + 2)
+#define LED_CFGLR_8(s, m)  LED_CFGLR_4(s, m), LED_CFGLR_4(s, (m) + 4)
+#define LED_CFGLR_16(s, m) LED_CFGLR_8(s, m), LED_CFGLR_8(s, (m) + 8)
+#define LED_CFGLR_32(s, m) LED_CFGLR_16(s, m), LED_CFGLR_16(s, (m) + 16)
+#define LED_CFGLR_SLOT2(s, n) CONCAT_INDIRECT(LED_CFGLR_, n)(s, 0)
+#define LED_CFGLR_SLOT(s)  {LED_CFGLR_SLOT2(s, LED_SLOT_MASKS)}
+#define LED_BSHR(s)        {LED_PORT_BSHR(0, s), LED_PORT_BSHR(1, s), LED_PORT_BSHR(2, s)}
+
+#if LED_MATRIX_SCAN_ROWS
+#define LED_SLOT_MASKS 32
+#else
+#define LED_SLOT_MASKS 2
+#endif
+
+static const uint32_t led_slot_cfglr[LED_SLOTS][LED_SLOT_MASKS][LED_PORTS] = {LED_FOR_EACH_SLOT(LED_CFGLR_SLOT)};
+static const uint32_t led_slot_bshr[LED_SLOTS][LED_PORTS]                  = {LED_FOR_EACH_SLOT(LED_BSHR)};
+static const uint32_t led_float_cfglr[LED_PORTS] = {LED_PORT_FLOAT(0), LED_PORT_FLOAT(1), LED_PORT_FLOAT(2)};
+
+// CFGLR of the pins not used by the LED matrix
+static uint32_t led_cfglr_base[LED_PORTS];
+
+static inline void led_write_cfglr(const uint32_t *cfglr)
+{
+    GPIOA->CFGLR = led_cfglr_base[0] | cfglr[0];
+    GPIOC->CFGLR = led_cfglr_base[1] | cfglr[1];
+    GPIOD->CFGLR = led_cfglr_base[2] | cfglr[2];
+}
+
+// Pull down the row pin and pull up the column pins of the LEDs in mask.
+static inline void led_slot_start(uint8_t slot, uint8_t row, uint8_t column, uint8_t mask)
+{
+    GPIOA->BSHR = led_slot_bshr[slot][0];
+    GPIOC->BSHR = led_slot_bshr[slot][1];
+    GPIOD->BSHR = led_slot_bshr[slot][2];
+    led_write_cfglr(led_slot_cfglr[slot][mask]);
+}
+
+// Change the LEDs on from old to mask.
+static inline void led_slot_update(uint8_t slot, uint8_t row, uint8_t column, uint8_t old, uint8_t mask)
+{
+    led_write_cfglr(led_slot_cfglr[slot][mask]);
+}
+
+// Put all pins in high impedance mode.
+static inline void led_slot_end(uint8_t row, uint8_t column, uint8_t mask)
+{
+    led_write_cfglr(led_float_cfglr);
+}
+
+static inline void led_matrix_init()
+{
+    GPIO_port_enable(GPIO_port_A);
+    GPIO_port_enable(GPIO_port_C);
+    GPIO_port_enable(GPIO_port_D);
+
+    led_cfglr_base[0] = GPIOA->CFGLR & ~LED_PORT_MASK(0);
+    led_cfglr_base[1] = GPIOC->CFGLR & ~LED_PORT_MASK(1);
+    led_cfglr_base[2] = GPIOD->CFGLR & ~LED_PORT_MASK(2);
+    led_write_cfglr(led_float_cfglr);
+}
+#else
+// The column pin of the i-th LED in the slot, the column and row cannot be the same pin.
+static inline uint8_t led_column_pin(uint8_t row, uint8_t column, uint8_t i)
+{
+    column += i;
+    return (column >= row) ? column + 1 : column;
+}
+
+// Pull down the row pin and pull up the column pins of the LEDs in mask.
+static inline void led_slot_start(uint8_t slot, uint8_t row, uint8_t column, uint8_t mask)
+{
+    GPIO_pinMode(pins[row], GPIO_pinMode_O_pushPull, GPIO_Speed_10MHz);
+    GPIO_digitalWrite(pins[row], low);
+    for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+    {
+        if (mask & (1 << i))
+        {
+            uint8_t pin = led_column_pin(row, column, i);
+            GPIO_pinMode(pins[pin], GPIO_pinMode_O_pushPull, GPIO_Speed_10MHz);
+            GPIO_digitalWrite(pins[pin], high);
+        }
+    }
+}
+
+// Change the LEDs on from old to mask, the column pins of the LEDs turned off are put in high impedance mode.
+static inline void led_slot_update(uint8_t slot, uint8_t row, uint8_t column, uint8_t old, uint8_t mask)
+{
+    for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+    {
+        uint8_t pin = led_column_pin(row, column, i);
+        if ((old & ~mask) & (1 << i))
+        {
+            GPIO_pinMode(pins[pin], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+        }
+        else if ((mask & ~old) & (1 << i))
+        {
+            GPIO_pinMode(pins[pin], GPIO_pinMode_O_pushPull, GPIO_Speed_10MHz);
+            GPIO_digitalWrite(pins[pin], high);
+        }
+    }
+}
+
+// Put the row pin and the column pins of the LEDs in mask in high impedance mode.
+static inline void led_slot_end(uint8_t row, uint8_t column, uint8_t mask)
+{
+    led_slot_update(0, row, column, mask, 0);
+    GPIO_pinMode(pins[row], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+}
+
+static inline void led_matrix_init()
+{
+    GPIO_port_enable(GPIO_port_A);
+    GPIO_port_enable(GPIO_port_C);
+    GPIO_port_enable(GPIO_port_D);
+
+    for (uint8_t i = 0; i < LED_MATRIX_NUM_PINS; i++)
+    {
+        GPIO_pinMode(pins[i], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+    }
+}
+#endif
+
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#if !LED_MATRIX_SCAN_ROWS || !LED_MATRIX_PORT_TABLES || LED_MATRIX_PWM != LED_PWM_LINEAR || LED_MATRIX_SKIP_DARK
+#error "LED_TIMER_DMA needs LED_MATRIX_SCAN_ROWS, LED_MATRIX_PORT_TABLES, LED_PWM_LINEAR and no LED_MATRIX_SKIP_DARK"
+#endif
+// The LED matrix is refreshed by DMA without any interrupt, with the same scan and PWM as LED_PWM_LINEAR.
+//
+//  - Every update of TIM1 ends a tick, TIM1 update, CH4 and CH3 requests copy the CFGLR words of port A, C and D for
+//    the next tick from led_dma_cfglr[] (DMA1 channel 5, 4 and 6).
+//  - TIM2 counts TIM1 updates, every LED_PWM_CYCLES ticks its update, CH3 and CH2 requests copy the BSHR words of
+//    port A, C and D for the next slot from led_dma_bshr[] (DMA1 channel 2, 1 and 7).
+//
+// A tick is written at the end of the one before, so entry i of the tables is for tick or slot i + 1. The one-row
+// scan keeps the CFGLR table at 6 x 16 x 3 words, the one-LED scan would take more RAM than there is.
+#define LED_DMA_TICKS (LED_SLOTS * LED_PWM_CYCLES)
+
+static uint32_t led_dma_cfglr[LED_PORTS][LED_DMA_TICKS];
+_Static_assert(sizeof(led_dma_cfglr) <= 1536, "DMA table too large for the 2KB RAM, lower LED_MATRIX_PWM_BITS");
+
+#define LED_DMA_BSHR(x, s) LED_PORT_BSHR(x, ((s) + 1) % LED_SLOTS)
+#define LED_DMA_BSHR_0(s)  LED_DMA_BSHR(0, s)
+#define LED_DMA_BSHR_1(s)  LED_DMA_BSHR(1, s)
+#define LED_DMA_BSHR_2(s)  LED_DMA_BSHR(2, s)
+static const uint32_t led_dma_bshr[LED_PORTS][LED_SLOTS] = {
+    {LED_FOR_EACH_SLOT(LED_DMA_BSHR_0)},
+    {LED_FOR_EACH_SLOT(LED_DMA_BSHR_1)},
+    {LED_FOR_EACH_SLOT(LED_DMA_BSHR_2)},
+};
+
+// Build the CFGLR words of every tick from led_duty_cycles, the LEDs of a slot are on while the tick is below their
+// duty cycles.
+static inline void led_dma_build()
+{
+    const uint8_t *frame = led_duty_cycles;
+    uint16_t       i     = LED_DMA_TICKS - 1;
+    for (uint8_t slot = 0, led = 0; slot < LED_SLOTS; slot++, led += LED_SLOT_COLUMNS)
+    {
+        for (uint8_t cycle = 0; cycle < LED_PWM_CYCLES; cycle++)
+        {
+            uint8_t mask = 0;
+            for (uint8_t k = 0; k < LED_SLOT_COLUMNS; k++)
+            {
+                if (led_get_duty(frame, led + k) > cycle)
+                {
+                    mask |= 1 << k;
+                }
+            }
+
+            const uint32_t *cfglr = led_slot_cfglr[slot][mask];
+            for (uint8_t x = 0; x < LED_PORTS; x++)
+            {
+                led_dma_cfglr[x][i] = led_cfglr_base[x] | cfglr[x];
+            }
+            i = (i == LED_DMA_TICKS - 1) ? 0 : i + 1;
+        }
+    }
+}
+
+// Wait until the DMA is at the n-th last tick of the frame, not at all before it is started.
+static inline void led_dma_wait(uint16_t n)
+{
+    if (DMA1_Channel5->CFGR & DMA_CFGR1_EN)
+    {
+        while (DMA1_Channel5->CNTR != n)
+        {
+        }
+    }
+}
+
+// Copy table to the register on every request, round and round.
+static inline void led_dma_channel(DMA_Channel_TypeDef *channel, volatile uint32_t *reg, const uint32_t *table,
+                                   uint16_t n)
+{
+    channel->PADDR = (uintptr_t)reg;
+    channel->MADDR = (uintptr_t)table;
+    channel->CNTR  = n;
+    channel->CFGR  = DMA_CFGR1_DIR | DMA_CFGR1_CIRC | DMA_CFGR1_MINC | DMA_CFGR1_PSIZE_1 | DMA_CFGR1_MSIZE_1 |
+                    DMA_CFGR1_PL | DMA_CFGR1_EN;
+}
+
+// Start up TIM1, TIM2 and the DMA channels refreshing the LED matrix.
+static inline void led_timer_init()
+{
+    led_dma_build();
+
+    // TIM1 ticks, the update is the trigger output for TIM2. Stopped until everything is set up.
+    GPIO_tim1_init();
+    TIM1->CTLR1 &= ~TIM_CEN;
+    TIM1->ATRLR  = LED_TICK_CYCLES - 1;
+    TIM1->CH3CVR = 0;
+    TIM1->CH4CVR = 0;
+    TIM1->CTLR2  = TIM_MMS_1;
+    TIM1->SWEVGR = TIM_UG;
+
+    // TIM2 counts the ticks from TIM1 (external clock mode 1 on ITR0), and updates once a slot.
+    GPIO_tim2_init();
+    TIM2->SMCFGR = TIM_SMS_2 | TIM_SMS_1 | TIM_SMS_0;
+    TIM2->ATRLR  = LED_PWM_CYCLES - 1;
+    TIM2->CH2CVR = 0;
+    TIM2->CH3CVR = 0;
+    TIM2->SWEVGR = TIM_UG;
+
+    RCC->AHBPCENR |= RCC_AHBPeriph_DMA1;
+    led_dma_channel(DMA1_Channel5, &GPIOA->CFGLR, led_dma_cfglr[0], LED_DMA_TICKS);
+    led_dma_channel(DMA1_Channel4, &GPIOC->CFGLR, led_dma_cfglr[1], LED_DMA_TICKS);
+    led_dma_channel(DMA1_Channel6, &GPIOD->CFGLR, led_dma_cfglr[2], LED_DMA_TICKS);
+    led_dma_channel(DMA1_Channel2, &GPIOA->BSHR, led_dma_bshr[0], LED_SLOTS);
+    led_dma_channel(DMA1_Channel1, &GPIOC->BSHR, led_dma_bshr[1], LED_SLOTS);
+    led_dma_channel(DMA1_Channel7, &GPIOD->BSHR, led_dma_bshr[2], LED_SLOTS);
+    TIM1->DMAINTENR = TIM_UDE | TIM_CC4DE | TIM_CC3DE;
+    TIM2->DMAINTENR = TIM_UDE | TIM_CC3DE | TIM_CC2DE;
+
+    // Show the first tick, the last entries of the tables, then start.
+    GPIOA->BSHR = led_dma_bshr[0][LED_SLOTS - 1];
+    GPIOC->BSHR = led_dma_bshr[1][LED_SLOTS - 1];
+    GPIOD->BSHR = led_dma_bshr[2][LED_SLOTS - 1];
+    GPIOA->CFGLR = led_dma_cfglr[0][LED_DMA_TICKS - 1];
+    GPIOC->CFGLR = led_dma_cfglr[1][LED_DMA_TICKS - 1];
+    GPIOD->CFGLR = led_dma_cfglr[2][LED_DMA_TICKS - 1];
+    TIM1->CNT = 0;
+    TIM1->CTLR1 |= TIM_CEN;
+}
+#endif
+
+#if LED_MATRIX_SKIP_DARK
+// Scan lists of the slots with at least one lit LED. led_matrix_update() builds the inactive list, the scan switches
+// to it at the start of the next frame.
+struct led_slot_list
+{
+    uint8_t  count;             // Number of lit slots
+    uint8_t  slots[LED_SLOTS];  // Lit slots in scan order
+    uint32_t idle;              // Cycles to stay idle after the lit slots
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME
+    uint32_t unit;  // LED_UNIT_CYCLES stretched so the lit slots fill the frame
+#endif
+};
+
+// The active list starts as a blank frame until the first led_matrix_update().
+static struct led_slot_list led_slot_lists[2] = {{.idle = LED_FRAME_CYCLES}};
+static volatile uint8_t     led_slot_list_active;
+
+// Row pin, column index of the first LED and first LED of each slot
+#define LED_SLOT_INFO(s) \
+    {LED_SLOT_ROW(s), LED_SLOT_FIRST(s), LED_SLOT_ROW(s) * (LED_MATRIX_NUM_PINS - 1) + LED_SLOT_FIRST(s)}
+static const struct
+{
+    uint8_t row, column, led;
+} led_slot_info[LED_SLOTS] = {LED_FOR_EACH_SLOT(LED_SLOT_INFO)};
+
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME
+// Unit cycles for 1 to LED_SLOTS lit slots
+#define LED_STRETCHED_UNIT(s) (LED_UNIT_CYCLES * LED_SLOTS / ((s) + 1))
+static const uint32_t led_stretched_units[LED_SLOTS] = {LED_FOR_EACH_SLOT(LED_STRETCHED_UNIT)};
+
+// Unit cycles of the current frame
+static uint32_t led_unit = LED_UNIT_CYCLES;
+#define LED_UNIT led_unit
+#else
+// Idle cycles for 0 to LED_SLOTS lit slots
+#define LED_IDLE_CYCLES(s) ((LED_SLOTS - (s)) * LED_SLOT_CYCLES)
+static const uint32_t led_idle_cycles[LED_SLOTS + 1] = {LED_FOR_EACH_SLOT(LED_IDLE_CYCLES), 0};
+#endif
+#endif
+
+#ifndef LED_UNIT
+#define LED_UNIT LED_UNIT_CYCLES
+#endif
+
+#if LED_FRAME_BUFFERS == 2
+// Frames started by the scan, and set by led_matrix_update() to swap the buffers at the start of the next frame
+static volatile uint32_t led_frame_count;
+static volatile uint8_t  led_frame_pending;
+#endif
+
+#if LED_MATRIX_QUEUE
+// Frames shown in turn by the scan, each for its own number of frames. The slot before tail is on display, so the
+// queue holds up to LED_MATRIX_QUEUE - 1 frames ahead of it.
+static struct
+{
+    uint8_t          frames[LED_MATRIX_QUEUE][LED_FRAME_BYTES];
+    uint8_t          hold[LED_MATRIX_QUEUE];  // Frames each queued frame is shown for
+    volatile uint8_t head;                    // Next slot to fill, written by led_queue_push()
+    volatile uint8_t tail;                    // Next slot to show, written by the scan
+    volatile uint8_t wait;                    // Frames left to show the queued frame on display
+} led_queue;
+#endif
+
+// Frames at LED_MATRIX_REFRESH_HZ closest to ms milliseconds, for led_queue_push()
+#define LED_FRAMES_MS(ms) (((ms) * LED_MATRIX_REFRESH_HZ + 500) / 1000)
+
+// Call after changing led_duty_cycles to show them from the next frame on, then led_wait_vsync() before changing
+// them again. With LED_MATRIX_SKIP_DARK, the scan list is rebuilt here and swapped in with the buffers. With
+// LED_TIMER_DMA, the DMA table is rebuilt as the DMA enters the last tick of a frame, well ahead of the DMA.
+static inline void led_matrix_update()
+{
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+    led_dma_wait(1);
+    led_dma_build();
+#else
+#if LED_MATRIX_SKIP_DARK
+    // Once pending is cleared the ISR will not swap, so the inactive list is safe to write.
+    led_frame_pending            = 0;
+    struct led_slot_list *list   = &led_slot_lists[led_slot_list_active ^ 1];
+    const uint8_t        *frame  = led_duty_cycles;
+    uint8_t               count  = 0;
+    for (uint8_t s = 0, led = 0; s < LED_SLOTS; s++, led += LED_SLOT_COLUMNS)
+    {
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (led_get_duty(frame, led + i) != 0)
+            {
+                list->slots[count++] = s;
+                break;
+            }
+        }
+    }
+
+    list->count = count;
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME
+    list->idle = count ? 0 : LED_FRAME_CYCLES;
+    list->unit = count ? led_stretched_units[count - 1] : LED_UNIT_CYCLES;
+#else
+    list->idle = led_idle_cycles[count];
+#endif
+#endif
+    led_frame_pending = 1;
+#endif
+}
+
+// Wait for the start of the next frame. After a led_matrix_update(), led_duty_cycles then holds the frame being
+// shown, ready to be changed for the next one.
+void led_wait_vsync()
+{
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+    led_dma_wait(LED_DMA_TICKS);
+#else
+    // Read pending first, if the swap happens in between the wait takes one more frame.
+    uint8_t  swap  = led_frame_pending;
+    uint32_t frame = led_frame_count;
+    while (frame == led_frame_count)
+    {
+    }
+
+    if (swap)
+    {
+        memcpy(led_duty_cycles, led_front, LED_FRAME_BYTES);
+    }
+#endif
+}
+
+#if LED_MATRIX_QUEUE
+// Queue a copy of led_duty_cycles to be shown for the given frames after the queued frames, waiting while the queue
+// is full. The scan switches frames at frame starts, so the playback keeps to the refresh clock however long the
+// frames take to render, as long as the queue does not run dry.
+void led_queue_push(uint8_t frames)
+{
+    uint8_t head = led_queue.head;
+    uint8_t next = (head + 1 == LED_MATRIX_QUEUE) ? 0 : head + 1;
+    while (next == led_queue.tail)
+    {
+    }
+
+    memcpy(led_queue.frames[head], led_duty_cycles, LED_FRAME_BYTES);
+    led_queue.hold[head] = frames;
+    __asm__ volatile("" ::: "memory");  // The frame is written before the scan can see it.
+    led_queue.head = next;
+}
+
+// Wait until the last queued frame has been shown for its frames. It stays on display until the next
+// led_matrix_update() or led_queue_push().
+void led_queue_wait()
+{
+    while (led_queue.tail != led_queue.head || led_queue.wait != 0)
+    {
+    }
+}
+#endif
+
+// The slot being scanned, it starts from the last slot so the first step moves to slot 0.
+static struct
+{
+    uint8_t slot, row, column;  // Slot, its row pin and the column index of its first LED
+    uint8_t mask;               // LEDs of the slot currently on
+    uint8_t first;              // First LED of the slot
+#if LED_MATRIX_PWM == LED_PWM_BAM
+    // BAM packs the bit planes straight from the frame.
+#elif LED_MATRIX_PACKED || LED_MATRIX_SCROLL
+    uint8_t led[LED_SLOT_COLUMNS];  // Duty cycles of the LEDs of the slot, unpacked when the slot starts
+#else
+    const uint8_t *led;  // Duty cycle of the first LED of the slot
+#endif
+#if LED_MATRIX_SCROLL
+    uint8_t origin;  // led_origin of the current frame
+#endif
+#if LED_MATRIX_SKIP_DARK
+    uint8_t                     pos;   // Position of the slot in the scan list
+    const struct led_slot_list *list;  // Scan list of the current frame
+#endif
+} led_scan = {
+    .slot   = LED_SLOTS - 1,
+    .row    = LED_MATRIX_NUM_PINS - 1,
+    .column = LED_MATRIX_NUM_PINS - 1 - LED_SLOT_COLUMNS,
+    .first  = LED_MATRIX_SIZE - LED_SLOT_COLUMNS,
+#if LED_MATRIX_SKIP_DARK
+    .list   = led_slot_lists,
+#endif
+};
+
+#if LED_MATRIX_SCROLL
+// LED i of the matrix shows LED (i + origin) of the frame, read at the start of every frame. Past the last LED, the
+// scan wraps around to the first one, or shows dark LEDs with LED_SCROLL_NO_WRAP.
+#define LED_SCROLL_ORIGIN  0x7f
+#define LED_SCROLL_NO_WRAP 0x80
+static volatile uint8_t led_origin;
+
+// Scroll the matrix from the next frame on, in place of moving the duty cycles. With wrap, any origin is taken modulo
+// LED_MATRIX_SIZE, without it an origin of LED_MATRIX_SIZE or more leaves the matrix dark. The scan only wraps once,
+// so the origin is reduced here, by subtraction as there is no divide instruction.
+static inline void led_scroll(uint8_t origin, uint8_t wrap)
+{
+    if (!wrap)
+    {
+        led_origin = ((origin < LED_MATRIX_SIZE) ? origin : LED_MATRIX_SIZE) | LED_SCROLL_NO_WRAP;
+        return;
+    }
+    while (origin >= LED_MATRIX_SIZE)
+    {
+        origin -= LED_MATRIX_SIZE;
+    }
+    led_origin = origin;
+}
+
+// Duty cycle the scan shows on LED i
+static inline uint8_t led_scan_duty(const uint8_t *frame, uint8_t i)
+{
+    i += led_scan.origin & LED_SCROLL_ORIGIN;
+    if (i >= LED_MATRIX_SIZE)
+    {
+        if (led_scan.origin & LED_SCROLL_NO_WRAP)
+        {
+            return 0;
+        }
+        i -= LED_MATRIX_SIZE;
+    }
+    return led_get_duty(frame, i);
+}
+#else
+#define led_scan_duty led_get_duty
+#endif
+
+#if LED_FRAME_BUFFERS == 2
+// Start a new frame, with the buffers and scan list of led_matrix_update() if there are new ones.
+static inline void led_frame_next()
+{
+#if LED_MATRIX_SCROLL
+    led_scan.origin = led_origin;
+#endif
+    if (led_frame_pending)
+    {
+        uint8_t *front = led_duty_cycles;
+#if LED_MATRIX_QUEUE
+        // The front buffer may be a queued frame, the back buffer is the other frame buffer.
+        led_duty_cycles = (front == led_frame_buffers[0]) ? led_frame_buffers[1] : led_frame_buffers[0];
+#else
+        led_duty_cycles = led_front;
+#endif
+        led_front = front;
+#if LED_MATRIX_SKIP_DARK
+        led_slot_list_active ^= 1;
+        led_scan.list = &led_slot_lists[led_slot_list_active];
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME
+        led_unit = led_scan.list->unit;
+#endif
+#endif
+        led_frame_pending = 0;
+    }
+#if LED_MATRIX_QUEUE
+    // The next queued frame replaces the frame on display once its frames are up. Frames queued for 0 frames are
+    // skipped, unless the queue has nothing after them.
+    if (led_queue.wait != 0)
+    {
+        led_queue.wait--;
+    }
+    uint8_t tail = led_queue.tail;
+    while (led_queue.wait == 0 && tail != led_queue.head)
+    {
+        led_front      = led_queue.frames[tail];
+        led_queue.wait = led_queue.hold[tail];
+        tail           = (tail + 1 == LED_MATRIX_QUEUE) ? 0 : tail + 1;
+    }
+    led_queue.tail = tail;
+#endif
+    led_frame_count++;
+}
+#else
+static inline void led_frame_next() {}
+#endif
+
+// Point led_scan.led to the duty cycles of the slot, the front buffer does not change until the next frame.
+static inline void led_scan_load()
+{
+#if LED_MATRIX_PWM == LED_PWM_BAM
+#elif LED_MATRIX_PACKED || LED_MATRIX_SCROLL
+    const uint8_t *frame = led_front;
+    for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+    {
+        led_scan.led[i] = led_scan_duty(frame, led_scan.first + i);
+    }
+#else
+    led_scan.led = led_front + led_scan.first;
+#endif
+}
+
+// Turn off the current slot and move to the next one. Returns the cycles to stay idle before the next slot starts,
+// 0 to start it now.
+static inline uint32_t led_scan_next()
+{
+    led_slot_end(led_scan.row, led_scan.column, led_scan.mask);
+    led_scan.mask = 0;
+#if LED_MATRIX_SKIP_DARK
+    const struct led_slot_list *list = led_scan.list;
+    if (++led_scan.pos == list->count && list->idle != 0)
+    {
+        // All lit slots are done, stay dark for the rest of the frame.
+        return list->idle;
+    }
+
+    if (led_scan.pos >= list->count)
+    {
+        led_scan.pos = 0;
+        led_frame_next();
+        list = led_scan.list;
+        if (list->count == 0)
+        {
+            return list->idle;
+        }
+    }
+
+    uint8_t slot    = list->slots[led_scan.pos];
+    led_scan.slot   = slot;
+    led_scan.row    = led_slot_info[slot].row;
+    led_scan.column = led_slot_info[slot].column;
+    led_scan.first  = led_slot_info[slot].led;
+#else
+    led_scan.slot++;
+    led_scan.first += LED_SLOT_COLUMNS;
+    led_scan.column += LED_SLOT_COLUMNS;
+    if (led_scan.column == LED_MATRIX_NUM_PINS - 1)
+    {
+        // Move to the next row.
+        led_scan.column = 0;
+        if (++led_scan.row == LED_MATRIX_NUM_PINS)
+        {
+            // Reset to the first LED.
+            led_frame_next();
+            led_scan.row   = 0;
+            led_scan.slot  = 0;
+            led_scan.first = 0;
+        }
+    }
+#endif
+    led_scan_load();
+    return 0;
+}
+
+// First LED of the slot after the current one, as far as can be told before the next frame starts.
+static inline uint8_t led_scan_peek()
+{
+#if LED_MATRIX_SKIP_DARK
+    const struct led_slot_list *list = led_scan.list;
+    uint8_t                     pos  = led_scan.pos + 1;
+    if (pos >= list->count)
+    {
+        pos = 0;
+    }
+    return led_slot_info[list->slots[pos]].led;
+#else
+    uint8_t led = led_scan.first + LED_SLOT_COLUMNS;
+    return led == LED_MATRIX_SIZE ? 0 : led;
+#endif
+}
+
+#if LED_MATRIX_PWM == LED_PWM_BAM
+// Bit planes of the next slot, bit i of led_bitplanes[b] is bit b of the duty cycle of the i-th LED.
+static uint8_t        led_bitplanes[LED_MATRIX_PWM_BITS];
+static const uint8_t *led_bitplanes_frame;  // The frame and first LED packed in led_bitplanes
+static uint8_t        led_bitplanes_led;
+#if LED_MATRIX_SCROLL
+static uint8_t led_bitplanes_origin;
+#define LED_BITPLANES_MOVED() (led_bitplanes_origin != led_scan.origin)
+#else
+#define LED_BITPLANES_MOVED() 0
+#endif
+
+static inline void led_pack_bitplanes(uint8_t led)
+{
+    const uint8_t *frame = led_front;
+    led_bitplanes_frame  = frame;
+    led_bitplanes_led    = led;
+#if LED_MATRIX_SCROLL
+    led_bitplanes_origin = led_scan.origin;
+#endif
+    for (uint8_t b = 0; b < LED_MATRIX_PWM_BITS; b++)
+    {
+        led_bitplanes[b] = 0;
+    }
+
+    for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+    {
+        uint8_t duty = led_scan_duty(frame, led + i);
+        for (uint8_t b = 0; duty != 0; b++, duty >>= 1)
+        {
+            if (duty & 0x01)
+            {
+                led_bitplanes[b] |= 1 << i;
+            }
+        }
+    }
+}
+
+// Scan the LED matrix slot by slot with bit-angle modulation. Bit b of the duty cycles is shown for
+// (LED_BAM_UNIT_CYCLES << b), so 2^LED_MATRIX_PWM_BITS brightness levels take only LED_MATRIX_PWM_BITS steps per
+// slot.
+// Returns the cycles until the next step.
+static inline uint32_t led_matrix_run()
+{
+    static uint8_t bit = 0;
+
+    if (bit == 0)
+    {
+        uint32_t idle = led_scan_next();
+        if (idle)
+        {
+#if LED_MATRIX_SKIP_DARK
+            // Nothing is packed through dark frames, and the buffer packed before them can be the front buffer
+            // again after them, with other duty cycles.
+            if (led_scan.list->count == 0)
+            {
+                led_bitplanes_frame = NULL;
+            }
+#endif
+            return idle;
+        }
+
+        // The slot guessed by led_scan_peek() is wrong only on the first slot of a new frame buffer, scan list or
+        // scroll origin.
+        if (led_bitplanes_led != led_scan.first || led_bitplanes_frame != led_front || LED_BITPLANES_MOVED())
+        {
+            led_pack_bitplanes(led_scan.first);
+        }
+        led_scan.mask = led_bitplanes[0];
+        led_slot_start(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask);
+    }
+    else if (led_bitplanes[bit] != led_scan.mask)
+    {
+        led_slot_update(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask, led_bitplanes[bit]);
+        led_scan.mask = led_bitplanes[bit];
+    }
+
+    uint32_t cycles = LED_UNIT << bit;
+    if (++bit == LED_MATRIX_PWM_BITS)
+    {
+        // Pack the next slot while the longest bit is shown.
+        bit = 0;
+        led_pack_bitplanes(led_scan_peek());
+    }
+
+    return cycles;
+}
+#elif LED_MATRIX_PWM == LED_PWM_EVENT
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME || LED_PWM_CYCLES > 16
+// Cycles of n ticks, shift and add as there is no multiply instruction.
+static inline uint32_t led_ticks(uint8_t n)
+{
+    uint32_t cycles = 0;
+    for (uint32_t tick = LED_UNIT; n != 0; n >>= 1, tick <<= 1)
+    {
+        if (n & 0x01)
+        {
+            cycles += tick;
+        }
+    }
+    return cycles;
+}
+#else
+// Cycles of 0 to LED_PWM_CYCLES (up to 16) ticks
+#define LED_TICKS(n) ((n) * LED_TICK_CYCLES)
+static const uint32_t led_tick_cycles[] = {
+    LED_TICKS(0),  LED_TICKS(1),  LED_TICKS(2),  LED_TICKS(3),  LED_TICKS(4),  LED_TICKS(5),
+    LED_TICKS(6),  LED_TICKS(7),  LED_TICKS(8),  LED_TICKS(9),  LED_TICKS(10), LED_TICKS(11),
+    LED_TICKS(12), LED_TICKS(13), LED_TICKS(14), LED_TICKS(15), LED_TICKS(16),
+};
+
+#define led_ticks(n) led_tick_cycles[n]
+#endif
+
+// Scan the LED matrix slot by slot with the same PWM as LED_PWM_LINEAR, but only step when an LED changes state.
+// The LEDs are turned on at cycle 0, then the compare jumps straight to the next duty cycle among the LEDs still on,
+// so a slot takes one step plus one per distinct duty cycle below LED_PWM_CYCLES.
+//
+// Returns the cycles until the next step.
+static inline uint32_t led_matrix_run()
+{
+    static uint8_t cycle = 0;
+
+    if (cycle == 0)  // Initialization or moved to the next slot.
+    {
+        uint32_t idle = led_scan_next();
+        if (idle)
+        {
+            return idle;
+        }
+
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (led_scan.led[i] != 0)
+            {
+                led_scan.mask |= 1 << i;
+            }
+        }
+        led_slot_start(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask);
+    }
+    else
+    {
+        // Turn off the LEDs reached their duty cycles, or changed to a lower one since they were turned on.
+        uint8_t mask = led_scan.mask;
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (led_scan.led[i] <= cycle)
+            {
+                mask &= ~(1 << i);
+            }
+        }
+
+        if (mask != led_scan.mask)
+        {
+            led_slot_update(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask, mask);
+            led_scan.mask = mask;
+        }
+    }
 
-// Bit definitions for systick regs
-#define SYSTICK_SR_CNTIF   (1 << 0)
-#define SYSTICK_CTLR_STE   (1 << 0)
-#define SYSTICK_CTLR_STIE  (1 << 1)
-#define SYSTICK_CTLR_STCLK (1 << 2)
-#define SYSTICK_CTLR_STRE  (1 << 3)
-#define SYSTICK_CTLR_SWIE  (1 << 31)
+    // Find the next edge, the lowest duty cycle among the LEDs still on, or the end of the slot.
+    uint8_t next = LED_PWM_CYCLES;
+    for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+    {
+        if ((led_scan.mask & (1 << i)) && led_scan.led[i] < next)
+        {
+            next = led_scan.led[i];
+        }
+    }
 
-#define LED_MATRIX_NUM_PINS 6
-#define LED_MATRIX_SIZE     (LED_MATRIX_NUM_PINS * (LED_MATRIX_NUM_PINS - 1))
-#define LED_PWM_CYCLES      16
-
-uint8_t pins[LED_MATRIX_NUM_PINS] = {
-    GPIOv_from_PORT_PIN(GPIO_port_C, 1),  // IO1
-    GPIOv_from_PORT_PIN(GPIO_port_C, 2),  // IO2
-    GPIOv_from_PORT_PIN(GPIO_port_C, 4),  // IO3
-    GPIOv_from_PORT_PIN(GPIO_port_D, 5),  // IO4
-    GPIOv_from_PORT_PIN(GPIO_port_A, 1),  // IO5
-    GPIOv_from_PORT_PIN(GPIO_port_A, 2),  // IO6
-};
+    uint32_t cycles = led_ticks(next - cycle);
+    cycle           = (next == LED_PWM_CYCLES) ? 0 : next;
+    return cycles;
+}
+#else
+// Scan the LED matrix slot by slot. In each slot, the row pin is pulled down and the column pins of the lit LEDs
+// are pulled up at cycle 0, each LED is turned off at the cycle equals to its duty cycle.
+//
+// With LED_MATRIX_SCAN_ROWS, a slot is a whole row, each LED gets 1/6 duty instead of 1/30. Note every IO has a 1K
+// resistor, the row resistor is shared by all lit LEDs of the row, so the gain in brightness drops as more LEDs in
+// the row are lit.
+//
+// Returns the cycles until the next step.
+static inline uint32_t led_matrix_run()
+{
+    static uint8_t cycle = 0;
 
-// 5x6 pixel font
-static uint32_t font[] = {
-    0b00001000111011111111111111101010,  // heart
-    0b11111111111111111111111111111111,  // full square
-    0b00111111000110001100011000111111,  // square
-    0b00000000111001010010100111000000,  // smaller square
-    0b00000000000000100001000000000000,  // micro square
-    0b00000000000000000000000000000000,  // 0x20 space
-    0b00001000000000100001000010000100,  // 0x21 '!'
-    0b00000000000000000000000101001010,  // 0x22 '"'
-    0b00010101111101010010101111101010,  // 0x23 '#'
-    0b00001000111110100001011111000100,  // 0x24 '$'
-    0b00100011001000100010011000100000,  // 0x25 '%'
-    0b00101100100110101000100010100010,  // 0x26 '&'
-    0b00000000000000000000000010000100,  // 0x27 '''
-    0b00010000010000100001000010001000,  // 0x28 '('
-    0b00000100010000100001000010000010,  // 0x29 ')'
-    0b00001001010101110101010010000000,  // 0x2A '*'
-    0b00001000010011111001000010000000,  // 0x2B '+'
-    0b00000010011000110000000000000000,  // 0x2C ','
-    0b00000000000011111000000000000000,  // 0x2D '-'
-    0b00000000011000110000000000000000,  // 0x2E '.'
-    0b00000010001000100010001000000000,  // 0x2F '/'
-    0b00011101000110101101011000101110,  // 0x30 '0'
-    0b00011100010000100001000011000100,  // 0x31 '1'
-    0b00111110001000100010001000101110,  // 0x32 '2'
-    0b00011101000110000010001000101110,  // 0x33 '3'
-    0b00010000100011111010100110001000,  // 0x34 '4'
-    0b00011111000010000011110000101111,  // 0x35 '5'
-    0b00011101000110001011110001001100,  // 0x36 '6'
-    0b00001000010000100010001000011111,  // 0x37 '7'
-    0b00011101000110001011101000101110,  // 0x38 '8'
-    0b00011001000011110100011000101110,  // 0x39 '9'
-    0b00000000010000000000000010000000,  // 0x3A ':'
-    0b00000100010000000000000010000000,  // 0x3B ';'
-    0b00010000010000010001000100000000,  // 0x3C '<'
-    0b00000001111100000111110000000000,  // 0x3D '='
-    0b00000100010001000001000001000000,  // 0x3E '>'
-    0b00001000000001100100001000101110,  // 0x3F '?'
-    0b00000100110110101111011000101110,  // 0x40 '@'
-    0b00100011000110001111111000101110,  // 0x41 'A'
-    0b00011111000110001011111000101111,  // 0x42 'B'
-    0b00011101000100001000011000101110,  // 0x43 'C'
-    0b00011111000110001100011000101111,  // 0x44 'D'
-    0b00111110000100001011110000111111,  // 0x45 'E'
-    0b00000010000100001011110000111111,  // 0x46 'F'
-    0b00011101000110001110010000101110,  // 0x47 'G'
-    0b00100011000110001111111000110001,  // 0x48 'H'
-    0b00011100010000100001000010001110,  // 0x49 'I'
-    0b00001100100101000010000100011100,  // 0x4A 'J'
-    0b00100010100100101000110010101001,  // 0x4B 'K'
-    0b00111110000100001000010000100001,  // 0x4C 'L'
-    0b00100011000110001101011101110001,  // 0x4D 'M'
-    0b00100011000111001101011001110001,  // 0x4E 'N'
-    0b00011101000110001100011000101110,  // 0x4F 'O'
-    0b00000010000100001011111000101111,  // 0x50 'P'
-    0b00101100100110001100011000101110,  // 0x51 'Q'
-    0b00100010100100101011111000101111,  // 0x52 'R'
-    0b00011111000010000011100000111110,  // 0x53 'S'
-    0b00001000010000100001000010011111,  // 0x54 'T'
-    0b00011101000110001100011000110001,  // 0x55 'U'
-    0b00001000101010001100011000110001,  // 0x56 'V'
-    0b00010101010110101100011000110001,  // 0x57 'W'
-    0b00100011000101010001000101010001,  // 0x58 'X'
-    0b00001000010000100010101000110001,  // 0x59 'Y'
-    0b00111110000100010001000100011111,  // 0x5A 'Z'
-    0b00011000010000100001000010001100,  // 0X5B '['
-    0b00100000100000100000100000100000,  // 0X5C '\'
-    0b00001100010000100001000010000110,  // 0X5D ']'
-    0b00000000000010001010100010000000,  // 0X5E '^'
-    0b00111110000000000000000000000000,  // 0X5F '_'
-    0b00000000000000000000000010000010,  // 0X60 '`'
-    0b00101100100101001011100000000000,  // 0x61 'a'
-    0b00001110100101001001110000100001,  // 0x62 'b'
-    0b00011100000100001011100000000000,  // 0x63 'c'
-    0b00011100100101001011100100001000,  // 0x64 'd'
-    0b00011100000101111100010111000000,  // 0x65 'e'
-    0b00000100001000010001110001001100,  // 0x66 'f'
-    0b00001110100001110010010111000000,  // 0x67 'g'
-    0b00010010100101001001110000100001,  // 0x68 'b'
-    0b00000100001000010000110000000010,  // 0x69 'i'
-    0b00000110010000100001100000000100,  // 0x6A 'j'
-    0b00010010010100011001010100100001,  // 0x6B 'k'
-    0b00000100001000010000100001000010,  // 0x6C 'l'
-    0b00101011010110101010110000000000,  // 0x6D 'm'
-    0b00010010100101001001110000000000,  // 0x6E 'n'
-    0b00001100100101001001100000000000,  // 0x6F 'o'
-    0b00000010000100111010010011100000,  // 0x70 'p'
-    0b00010000100001110010010111000000,  // 0x71 'q'
-    0b00000100001010010011010000000000,  // 0x72 'r'
-    0b00001110100000110000010111000000,  // 0x73 's'
-    0b00011000001000010001110001000000,  // 0x74 't'
-    0b00001100100101001010010000000000,  // 0x75 'u'
-    0b00001000101010001100010000000000,  // 0x76 'v'
-    0b00010101010110101100010000000000,  // 0x57 'w'
-    0b00100010101000100010101000100000,  // 0x78 'x'
-    0b00011101000011100100101001000000,  // 0x79 'y'
-    0b00011110001000100011110000000000,  // 0x7A 'z'
-    0b00110000010000110001001100000000,  // 0X7B '{'
-    0b00001000010000000001000010000000,  // 0X7C '|'
-    0b00000110010001100001000001100000,  // 0X7D '}'
-    0b00000000100010101000100000000000,  // 0X7E '~'
-};
+    if (cycle == 0)  // Initialization or moved to the next slot.
+    {
+        uint32_t idle = led_scan_next();
+        if (idle)
+        {
+            return idle;
+        }
 
-// Effects
-static uint8_t effects[][LED_MATRIX_SIZE] = {
-    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16},       // Dot
-    {15, 12, 9, 6, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},      // Snake
-    {0, 0, 0, 0, 16, 0, 0, 0, 0, 16, 0, 0, 0, 0, 16, 0, 0, 0, 0, 16, 0, 0, 0, 0, 16, 0, 0, 0, 0, 16},  // Line
-    {0, 4, 8, 12, 16, 0, 4, 8, 12, 16, 0, 4, 8, 12, 16,
-     0, 4, 8, 12, 16, 0, 4, 8, 12, 16, 0, 4, 8, 12, 16},  // Diagonal wave
-};
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (led_scan.led[i] != 0)
+            {
+                led_scan.mask |= 1 << i;
+            }
+        }
+        led_slot_start(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask);
+    }
+    else
+    {
+        // Turn off the LEDs reached their duty cycles.
+        uint8_t mask = led_scan.mask;
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (led_scan.led[i] == cycle)
+            {
+                mask &= ~(1 << i);
+            }
+        }
 
-// PWM duty cycles of LEDs
-uint8_t led_duty_cycles[LED_MATRIX_SIZE];
+        if (mask != led_scan.mask)
+        {
+            led_slot_update(led_scan.slot, led_scan.row, led_scan.column, led_scan.mask, mask);
+            led_scan.mask = mask;
+        }
+    }
 
-static inline void led_matrix_run();
+    // Move to the next slot after LED_PWM_CYCLES
+    if (++cycle == LED_PWM_CYCLES)
+    {
+        cycle = 0;
+    }
 
-#define BOARD 0
+    return LED_UNIT;
+}
+#endif
 
-// Start up the SysTick IRQ
-void systick_init(void)
+// Set the duty cycle of pixel (x, y) in led_duty_cycles, pixels outside the matrix are ignored. Call
+// led_matrix_update() after the last change.
+static inline void led_set_pixel(uint8_t x, uint8_t y, uint8_t duty)
 {
-    // Disable default SysTick behavior
-    SysTick->CTLR = 0;
+    if (x < LED_MATRIX_WIDTH && y < LED_MATRIX_HEIGHT)
+    {
+        led_set_duty(led_duty_cycles, led_pixels[y * LED_MATRIX_WIDTH + x], duty);
+    }
+}
 
-    // Enable the SysTick IRQ
-    NVIC_EnableIRQ(SysTicK_IRQn);
+// Duty cycle of pixel (x, y) in led_duty_cycles, 0 outside the matrix
+static inline uint8_t led_get_pixel(uint8_t x, uint8_t y)
+{
+    if (x < LED_MATRIX_WIDTH && y < LED_MATRIX_HEIGHT)
+    {
+        return led_get_duty(led_duty_cycles, led_pixels[y * LED_MATRIX_WIDTH + x]);
+    }
+    return 0;
+}
 
-    // Set the tick interval
-    SysTick->CMP = (FUNCONF_SYSTEM_CORE_CLOCK / 50000) - 1;
+// Bit mask of the LEDs lit by a 5x6 glyph drawn at pixel (0, 0), for led_mask. Rotated by 90 or 270 degrees, the
+// matrix is 6x5 pixels and the bottom line of the glyph is cut off.
+static uint32_t led_glyph_mask(uint32_t glyph)
+{
+    uint32_t mask = 0;
+    for (uint8_t y = 0; y < LED_MATRIX_ROWS; y++)
+    {
+        for (uint8_t x = 0; x < LED_MATRIX_COLUMNS; x++, glyph >>= 1)
+        {
+            if ((glyph & 0x01) && y < LED_MATRIX_HEIGHT)
+            {
+                mask |= 1UL << led_pixels[y * LED_MATRIX_WIDTH + x];
+            }
+        }
+    }
+    return mask;
+}
 
-    // Start at zero
-    SysTick->CNT = 0;
+// Draw code point cp into led_duty_cycles
+static void led_draw_char(uint16_t cp)
+{
+    uint32_t mask  = led_glyph_mask(led_glyph(cp));
+    uint8_t *frame = led_duty_cycles;
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+    {
+        led_set_duty(frame, i, (mask & 0x01) ? LED_DUTY_MAX : 0);
+        mask >>= 1;
+    }
+}
 
-    // Enable SysTick counter, IRQ, HCLK/1
-    SysTick->CTLR = SYSTICK_CTLR_STE | SYSTICK_CTLR_STIE | SYSTICK_CTLR_STCLK;
+void led_putchar(uint16_t cp)
+{
+    led_draw_char(cp);
+    led_matrix_update();
+    led_wait_vsync();
 }
 
-// SysTick ISR just counts ticks
-__attribute__((interrupt)) void SysTick_Handler(void)
+void led_show_array(const char *arr, uint8_t size)
 {
-    // Move the compare further ahead in time. as a warning, if more than this length of time
-    // passes before triggering, you may miss your interrupt.
-    SysTick->CMP += (FUNCONF_SYSTEM_CORE_CLOCK / 50000);
+    // UTF-8, a character may take several of the size bytes
+    for (const char *end = arr + size; arr < end;)
+    {
+        uint16_t cp = led_utf8_next(&arr);
+#if LED_MATRIX_QUEUE
+        led_draw_char(cp);
+        led_queue_push(LED_FRAMES_MS(300));
+#else
+        led_putchar(cp);
+        Delay_Ms(300);
+#endif
+        led_profile_poll();
+    }
+#if LED_MATRIX_QUEUE
+    led_queue_wait();
+#endif
+}
 
-    // Clear IRQ
-    SysTick->SR = 0;
+// Text rendered once into pixel columns for led_marquee_show(), bit y of a column lights line y
+static struct
+{
+    uint8_t columns[LED_MATRIX_MARQUEE_COLUMNS];
+    uint8_t length;
+} led_marquee;
+
+// Render UTF-8 text into the marquee columns with the proportional font, with spacing blank columns after every glyph.
+// The text is cut off at LED_MATRIX_MARQUEE_COLUMNS.
+void led_marquee_render(const char *text, uint8_t spacing)
+{
+    uint8_t n = 0;
+    while (*text != 0)
+    {
+        uint8_t i = led_glyph_index(led_utf8_next(&text));
+        if (i != LED_GLYPH_NONE)
+        {
+            uint8_t columns[LED_MATRIX_COLUMNS];
+            uint8_t width = led_glyph_columns(i, columns);
+            for (uint8_t c = 0; c < width && n < LED_MATRIX_MARQUEE_COLUMNS; c++)
+            {
+                led_marquee.columns[n++] = columns[c];
+            }
+        }
 
-    led_matrix_run();
+        for (uint8_t x = 0; x < spacing && n < LED_MATRIX_MARQUEE_COLUMNS; x++)
+        {
+            led_marquee.columns[n++] = 0;
+        }
+    }
+    led_marquee.length = n;
 }
 
-static inline void led_matrix_init()
+// Slide the rendered text from the right edge to the left, one pixel column every `frames` frames. Each step only
+// copies LED_MATRIX_WIDTH columns of bits into the frame, the glyphs are not looked at again.
+void led_marquee_show(uint8_t frames)
 {
-    GPIO_port_enable(GPIO_port_A);
-    GPIO_port_enable(GPIO_port_C);
-    GPIO_port_enable(GPIO_port_D);
+    for (int16_t offset = 1 - LED_MATRIX_WIDTH; offset <= led_marquee.length; offset++)
+    {
+        for (uint8_t x = 0; x < LED_MATRIX_WIDTH; x++)
+        {
+            int16_t column = offset + x;
+            uint8_t bits   = (column >= 0 && column < led_marquee.length) ? led_marquee.columns[column] : 0;
+            for (uint8_t y = 0; y < LED_MATRIX_HEIGHT; y++, bits >>= 1)
+            {
+                led_set_pixel(x, y, (bits & 0x01) ? LED_DUTY_MAX : 0);
+            }
+        }
+#if LED_MATRIX_QUEUE
+        led_queue_push(frames);
+#else
+        led_matrix_update();
+        for (uint8_t f = 0; f < frames; f++)
+        {
+            led_wait_vsync();
+        }
+#endif
+        led_profile_poll();
+    }
+#if LED_MATRIX_QUEUE
+    led_queue_wait();
+#endif
+}
 
-    for (uint8_t i = 0; i < LED_MATRIX_NUM_PINS; i++)
+// Set the brightness of LED i, 0 to 255 on a perceptual scale. Call led_matrix_update() after the last change.
+static inline void led_set_brightness(uint8_t i, uint8_t brightness)
+{
+    led_set_duty(led_duty_cycles, i, led_gamma[brightness]);
+}
+
+// Set the brightness of all LEDs, 0 to 255 on a perceptual scale
+void led_show_brightness(const uint8_t *brightness)
+{
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
     {
-        GPIO_pinMode(pins[i], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+        led_set_brightness(i, brightness[i]);
+    }
+    led_matrix_update();
+    led_wait_vsync();
+}
+
+// Layers for led_compose(), duty cycles in the same layout as led_duty_cycles. Bit i of led_mask selects LED i of
+// the foreground, the other LEDs show the background.
+static uint8_t  led_background[LED_FRAME_BYTES];
+static uint8_t  led_foreground[LED_FRAME_BYTES];
+static uint32_t led_mask;
+
+// Blend modes of the foreground LEDs selected by led_mask
+#define LED_BLEND_MAX     0  // The brighter of the two layers
+#define LED_BLEND_ADD     1  // The sum of the two layers, up to LED_DUTY_MAX
+#define LED_BLEND_REPLACE 2  // The foreground
+
+// Shift of a layer brightness down to a quarter, to dim the background under the foreground
+#define LED_LAYER_QUARTER 2
+
+// Set the brightness of LED i of a layer, 0 to 255 on a perceptual scale
+static inline void led_layer_set(uint8_t *layer, uint8_t i, uint8_t brightness)
+{
+    led_set_duty(layer, i, led_gamma[brightness]);
+}
+
+// Flatten the layers into led_duty_cycles and show them from the next frame on, once per frame when called in a
+// loop. A pixel takes a few loads, a compare and a store, about 1% of 8MHz for 30 pixels at 104Hz.
+void led_compose(uint8_t blend)
+{
+    uint8_t *frame = led_duty_cycles;
+    uint32_t mask  = led_mask;
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++, mask >>= 1)
+    {
+        uint8_t duty = led_get_duty(led_background, i);
+        if (mask & 0x01)
+        {
+            uint8_t fg = led_get_duty(led_foreground, i);
+            if (blend == LED_BLEND_REPLACE || (blend == LED_BLEND_MAX && fg > duty))
+            {
+                duty = fg;
+            }
+            else if (blend == LED_BLEND_ADD)
+            {
+                uint16_t sum = duty + fg;
+                duty         = (sum > LED_DUTY_MAX) ? LED_DUTY_MAX : sum;
+            }
+        }
+        led_set_duty(frame, i, duty);
+    }
+    led_matrix_update();
+    led_wait_vsync();
+}
+
+// Procedural animations, each frame is computed from the frame number instead of stored. update() writes the next
+// frame into led_duty_cycles, which holds the frame on display when it is called, and init() sets up any state before
+// the first frame. budget is the cycles update() may take, checked with LED_MATRIX_PROFILE. A frame at
+// LED_MATRIX_REFRESH_HZ is LED_ANIMATION_FRAME_CYCLES, the ISR takes up to LED_MATRIX_ISR_BUDGET percent of it.
+struct led_animation
+{
+    const char *name;
+    void (*init)(void);  // NULL for none
+    void (*update)(uint32_t frame);
+    uint32_t budget;
+};
+
+#define LED_ANIMATION_FRAME_CYCLES    (FUNCONF_SYSTEM_CORE_CLOCK / LED_MATRIX_REFRESH_HZ)
+#define LED_ANIMATION_BUDGET(percent) (LED_ANIMATION_FRAME_CYCLES / 100 * (percent))
+
+// Diagonal bands moving to the bottom right, a wave every 8 pixels and every 64 frames
+static void led_animation_wave(uint32_t frame)
+{
+    uint8_t t = frame << 2;
+    for (uint8_t y = 0; y < LED_MATRIX_HEIGHT; y++)
+    {
+        for (uint8_t x = 0; x < LED_MATRIX_WIDTH; x++)
+        {
+            led_set_pixel(x, y, led_gamma[led_wave8(((x + y) << 5) - t)]);
+        }
     }
 }
 
-static inline void led_matrix_run()
+// Rings moving out from the center, the distance is counted in half pixels along x plus along y
+static void led_animation_ripple(uint32_t frame)
 {
-    static uint8_t  cycle = 0, row = 0, column = 0;
-    static uint8_t *led = led_duty_cycles;
+    uint8_t t = frame << 2;
+    for (uint8_t y = 0; y < LED_MATRIX_HEIGHT; y++)
+    {
+        int8_t dy = (y << 1) - (LED_MATRIX_HEIGHT - 1);
+        for (uint8_t x = 0; x < LED_MATRIX_WIDTH; x++)
+        {
+            int8_t  dx = (x << 1) - (LED_MATRIX_WIDTH - 1);
+            uint8_t d  = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+            led_set_pixel(x, y, led_gamma[led_wave8((d << 4) - t)]);
+        }
+    }
+}
 
-    // Turn off the LED by put column pin in high impedance mode.
-    // Put it at the beginning to avoid blink on cycle 0, although not noticeable.
-    if (cycle == *led)
+// A wave along x and a slower one along y, blended by a third wave over time
+static void led_animation_plasma(uint32_t frame)
+{
+    uint8_t t   = frame;
+    uint8_t mix = led_wave8(t);
+    for (uint8_t y = 0; y < LED_MATRIX_HEIGHT; y++)
     {
-        GPIO_pinMode(pins[column], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+        uint8_t wy = led_wave8((y << 5) + t);
+        for (uint8_t x = 0; x < LED_MATRIX_WIDTH; x++)
+        {
+            uint8_t wx = led_wave8((x << 6) - (t << 1));
+            led_set_pixel(x, y, led_gamma[led_lerp8(wx, wy, mix)]);
+        }
     }
-    else if (cycle == 0)  // Initialization or moved to the next LED.
+}
+
+// Xorshift state of the sparkles
+static uint16_t led_sparkle_seed;
+
+static void led_sparkle_init()
+{
+    led_sparkle_seed = 0xace1;
+    memset(led_duty_cycles, 0, LED_FRAME_BYTES);
+}
+
+// A random LED lights up every 8 frames and all lit LEDs fade by a level every 4 frames, the frame on display is
+// the only state.
+static void led_animation_sparkle(uint32_t frame)
+{
+    uint8_t *leds = led_duty_cycles;
+    if ((frame & 0x03) == 0)
     {
-        // Pull down the row pin and pull up the column pin to turn on the LED.
-        GPIO_pinMode(pins[row], GPIO_pinMode_O_pushPull, GPIO_Speed_10MHz);
-        GPIO_digitalWrite(pins[row], low);
-        GPIO_pinMode(pins[column], GPIO_pinMode_O_pushPull, GPIO_Speed_10MHz);
-        GPIO_digitalWrite(pins[column], high);
+        for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+        {
+            uint8_t duty = led_get_duty(leds, i);
+            if (duty)
+            {
+                led_set_duty(leds, i, duty - 1);
+            }
+        }
     }
+    if ((frame & 0x07) == 0)
+    {
+        uint16_t s = led_sparkle_seed;
+        s ^= s << 7;
+        s ^= s >> 9;
+        s ^= s << 8;
+        led_sparkle_seed = s;
 
-    // Move to the next LED after LED_PWM_CYCLES
-    if (++cycle == LED_PWM_CYCLES)
+        // 32 choices for 30 LEDs, the 2 left over skip a sparkle
+        uint8_t i = s & 0x1f;
+        if (i < LED_MATRIX_SIZE)
+        {
+            led_set_duty(leds, i, LED_DUTY_MAX);
+        }
+    }
+}
+
+static const struct led_animation led_animations[] = {
+    {"wave", NULL, led_animation_wave, LED_ANIMATION_BUDGET(5)},
+    {"ripple", NULL, led_animation_ripple, LED_ANIMATION_BUDGET(5)},
+    {"plasma", NULL, led_animation_plasma, LED_ANIMATION_BUDGET(8)},
+    {"sparkle", led_sparkle_init, led_animation_sparkle, LED_ANIMATION_BUDGET(2)},
+};
+
+#define LED_ANIMATIONS (sizeof(led_animations) / sizeof(led_animations[0]))
+
+// Run animation i for the given number of frames, a new frame every refresh. With LED_MATRIX_PROFILE, the cycles of
+// every update() are measured and printed at the end against the budget, the ISR time in between is included as it
+// takes from the same frame.
+void led_animation_run(uint8_t i, uint16_t frames)
+{
+    const struct led_animation *a = &led_animations[i];
+#if LED_MATRIX_PROFILE
+    uint32_t total = 0, max = 0, over = 0;
+#endif
+
+    if (a->init)
     {
-        cycle = 0;
-        led++;
+        a->init();
+    }
+    for (uint16_t frame = 0; frame < frames; frame++)
+    {
+#if LED_MATRIX_PROFILE
+        uint32_t start = SysTick->CNT;
+#endif
+        a->update(frame);
+#if LED_MATRIX_PROFILE
+        uint32_t cycles = SysTick->CNT - start;
+        total += cycles;
+        if (cycles > max)
+        {
+            max = cycles;
+        }
+        if (cycles > a->budget)
+        {
+            over++;
+        }
+#endif
+        led_matrix_update();
+        led_wait_vsync();
+        led_profile_poll();
+    }
+
+#if LED_MATRIX_PROFILE
+    printf("animation %s %u frames, mean %" PRIu32 ", max %" PRIu32 ", budget %" PRIu32 ", over %" PRIu32 "\n", a->name,
+           frames, frames ? total / frames : 0, max, a->budget, over);
+#endif
+}
+
+// Playback state of an animation stream from tools/stream_encoder. A stream is the number of frames, then each frame
+// is a header byte (LED_STREAM_HOLD and LED_STREAM_RECOLOR) and tokens over the pixels in order until all
+// LED_MATRIX_SIZE are covered. The first frame is a keyframe setting every pixel, the others are decoded over the frame
+// before.
+struct led_stream
+{
+    const uint8_t *first;   // First frame
+    const uint8_t *next;    // Next frame to decode
+    uint8_t        frames;  // Frames in the stream
+    uint8_t        frame;   // Index of the next frame
+};
+
+static void led_stream_open(struct led_stream *s, const uint8_t *data)
+{
+    s->frames = data[0];
+    s->first  = data + 1;
+    s->next   = s->first;
+    s->frame  = 0;
+}
 
-        // Put the current column pin in high impedance mode.
-        GPIO_pinMode(pins[column], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+// Decode the next frame into led_duty_cycles, which has to hold the frame before, and return the refresh frames to
+// show it for. After the last frame the stream starts over. Levels 0 to 15 are brightness 0 to 255 in steps of 17.
+static uint8_t led_stream_next(struct led_stream *s)
+{
+    if (s->frame == s->frames)
+    {
+        s->next  = s->first;
+        s->frame = 0;
+    }
 
-        // The column and row cannot be the same pin.
-        if (++column == row)
+    const uint8_t *d       = s->next;
+    uint8_t        header  = *d++;
+    uint8_t        recolor = header & LED_STREAM_RECOLOR;
+    uint8_t       *frame   = led_duty_cycles;
+    for (uint8_t p = 0; p < LED_MATRIX_SIZE;)
+    {
+        uint8_t token = *d++;
+        if (token & LED_STREAM_RUN)
+        {
+            uint8_t level = (token >> 3) & 0x0f;
+            uint8_t duty  = led_gamma[(level << 4) | level];
+            for (uint8_t n = (token & 0x07) + 1; n != 0 && p < LED_MATRIX_SIZE; n--, p++)
+            {
+                uint8_t led = led_pixels[p];
+                if (!recolor || led_get_duty(frame, led) != 0)
+                {
+                    led_set_duty(frame, led, duty);
+                }
+            }
+        }
+        else if (token & LED_STREAM_LITERAL)
+        {
+            uint8_t n = (token & 0x3f) + 1;
+            for (uint8_t k = 0; k < n && p < LED_MATRIX_SIZE; k++, p++)
+            {
+                uint8_t level = (k & 0x01) ? d[k >> 1] >> 4 : d[k >> 1] & 0x0f;
+                led_set_duty(frame, led_pixels[p], led_gamma[(level << 4) | level]);
+            }
+            d += (n + 1) >> 1;
+        }
+        else
         {
-            column++;
+            p += (token & 0x3f) + 1;
         }
+    }
 
-        // Move to the next row.
-        if (column == LED_MATRIX_NUM_PINS)
+    s->next = d;
+    s->frame++;
+    return header & LED_STREAM_HOLD;
+}
+
+// Play stream i of led_streams loops times, each frame shown for its own number of refresh frames. With
+// LED_MATRIX_PROFILE, the decode cycles of the frames are printed at the end.
+void led_stream_play(uint8_t i, uint8_t loops)
+{
+    struct led_stream s;
+    led_stream_open(&s, LED_ASSET_DATA(LED_ASSET_STREAMS, const uint8_t *const *)[i]);
+#if LED_MATRIX_PROFILE
+    uint32_t total = 0, max = 0;
+    uint16_t frames = 0;
+#endif
+
+    for (uint8_t loop = 0; loop < loops; loop++)
+    {
+        for (uint8_t f = 0; f < s.frames; f++)
         {
-            column = 0;
+#if LED_MATRIX_PROFILE
+            uint32_t start = SysTick->CNT;
+#endif
+            uint8_t hold = led_stream_next(&s);
+#if LED_MATRIX_PROFILE
+            uint32_t cycles = SysTick->CNT - start;
+            total += cycles;
+            frames++;
+            if (cycles > max)
+            {
+                max = cycles;
+            }
+#endif
+#if LED_MATRIX_QUEUE
+            led_queue_push(hold);
+#else
+            led_matrix_update();
+            for (; hold != 0; hold--)
+            {
+                led_wait_vsync();
+            }
+#endif
+            led_profile_poll();
+        }
+    }
+#if LED_MATRIX_QUEUE
+    led_queue_wait();
+#endif
 
-            // Put the current row pin in high impedance mode.
-            GPIO_pinMode(pins[row], GPIO_pinMode_I_floating, GPIO_Speed_10MHz);
+#if LED_MATRIX_PROFILE
+    printf("stream %u %u frames, decode mean %" PRIu32 ", max %" PRIu32 " cycles\n", i, frames,
+           frames ? total / frames : 0, max);
+#endif
+}
 
-            // Reset to the first LED.
-            if (++row == LED_MATRIX_NUM_PINS)
+// Transitions of led_transition(), the blends first. A wipe moves a soft edge across the matrix in the direction
+// named, a slide moves the frame out in that direction with the next one following it.
+#define LED_TRANSITION_CROSSFADE   0
+#define LED_TRANSITION_WIPE_LEFT   1
+#define LED_TRANSITION_WIPE_RIGHT  2
+#define LED_TRANSITION_WIPE_UP     3
+#define LED_TRANSITION_WIPE_DOWN   4
+#define LED_TRANSITION_DISSOLVE    5
+#define LED_TRANSITION_SLIDE_LEFT  6
+#define LED_TRANSITION_SLIDE_RIGHT 7
+#define LED_TRANSITION_SLIDE_UP    8
+#define LED_TRANSITION_SLIDE_DOWN  9
+#define LED_TRANSITIONS            10
+#define LED_TRANSITION_BLENDS      6
+
+// Progress of a blend at which pixel p starts to change, from 0 to LED_TRANSITION_START_MAX, built at compile time
+// for the mounted orientation. The dissolve takes a pseudo-random order, stepping by 157 modulo 256.
+#define LED_TRANSITION_START_MAX   192
+#define LED_TRANSITION_START(i, n) ((i) * LED_TRANSITION_START_MAX / ((n) - 1))
+#define LED_TRANSITION_X(p)        ((p) % LED_MATRIX_WIDTH)
+#define LED_TRANSITION_Y(p)        ((p) / LED_MATRIX_WIDTH)
+#define LED_TRANSITION_ZERO(p)     0
+#define LED_TRANSITION_LEFT(p)     LED_TRANSITION_START(LED_MATRIX_WIDTH - 1 - LED_TRANSITION_X(p), LED_MATRIX_WIDTH)
+#define LED_TRANSITION_RIGHT(p)    LED_TRANSITION_START(LED_TRANSITION_X(p), LED_MATRIX_WIDTH)
+#define LED_TRANSITION_UP(p)       LED_TRANSITION_START(LED_MATRIX_HEIGHT - 1 - LED_TRANSITION_Y(p), LED_MATRIX_HEIGHT)
+#define LED_TRANSITION_DOWN(p)     LED_TRANSITION_START(LED_TRANSITION_Y(p), LED_MATRIX_HEIGHT)
+#define LED_TRANSITION_RANDOM(p)   (((p) * 157 & 0xff) * 15 / 16)
+
+// Per blend, the start of every pixel and the shift from progress to weight. Once progress is past its start, a
+// pixel's weight of the next frame is (progress - start) >> shift up to 16, so the crossfade takes all of the
+// transition, a wipe edge a quarter of it and a dissolve pixel a sixteenth.
+static const struct
+{
+    uint8_t starts[LED_MATRIX_SIZE];
+    uint8_t shift;
+} led_transition_blends[LED_TRANSITION_BLENDS] = {
+    [LED_TRANSITION_CROSSFADE]  = {{LED_FOR_EACH_LED(LED_TRANSITION_ZERO)}, 4},
+    [LED_TRANSITION_WIPE_LEFT]  = {{LED_FOR_EACH_LED(LED_TRANSITION_LEFT)}, 2},
+    [LED_TRANSITION_WIPE_RIGHT] = {{LED_FOR_EACH_LED(LED_TRANSITION_RIGHT)}, 2},
+    [LED_TRANSITION_WIPE_UP]    = {{LED_FOR_EACH_LED(LED_TRANSITION_UP)}, 2},
+    [LED_TRANSITION_WIPE_DOWN]  = {{LED_FOR_EACH_LED(LED_TRANSITION_DOWN)}, 2},
+    [LED_TRANSITION_DISSOLVE]   = {{LED_FOR_EACH_LED(LED_TRANSITION_RANDOM)}, 0},
+};
+
+// Duty cycle of pixel (x, y) of a frame in the layout of led_duty_cycles
+static inline uint8_t led_frame_pixel(const uint8_t *frame, uint8_t x, uint8_t y)
+{
+    return led_get_duty(frame, led_pixels[y * LED_MATRIX_WIDTH + x]);
+}
+
+// Frame of a slide at progress t of 0 to 256, pixel (x, y) shows the pixel k pixels further along the direction of
+// the slide, in from while that is on the matrix and in to after it.
+static void led_transition_slide(const uint8_t *from, const uint8_t *to, uint8_t type, uint16_t t)
+{
+    uint8_t *frame = led_duty_cycles;
+    uint8_t  k     = (type == LED_TRANSITION_SLIDE_LEFT || type == LED_TRANSITION_SLIDE_RIGHT)
+                         ? LED_MUL_K(t, LED_MATRIX_WIDTH) >> 8
+                         : LED_MUL_K(t, LED_MATRIX_HEIGHT) >> 8;
+    for (uint8_t y = 0, p = 0; y < LED_MATRIX_HEIGHT; y++)
+    {
+        for (uint8_t x = 0; x < LED_MATRIX_WIDTH; x++, p++)
+        {
+            // Position along the slide, from 0 to the size of the matrix that way, the source pixel is k further.
+            uint8_t along = (type == LED_TRANSITION_SLIDE_LEFT)    ? x
+                            : (type == LED_TRANSITION_SLIDE_RIGHT) ? LED_MATRIX_WIDTH - 1 - x
+                            : (type == LED_TRANSITION_SLIDE_UP)    ? y
+                                                                   : LED_MATRIX_HEIGHT - 1 - y;
+            uint8_t size  = (type <= LED_TRANSITION_SLIDE_RIGHT) ? LED_MATRIX_WIDTH : LED_MATRIX_HEIGHT;
+            uint8_t moved = along + k;
+            const uint8_t *source = from;
+            if (moved >= size)
+            {
+                moved -= size;
+                source = to;
+            }
+            uint8_t sx = x, sy = y;
+            switch (type)
             {
-                row    = 0;
-                column = 1;
-                led    = led_duty_cycles;
+            case LED_TRANSITION_SLIDE_LEFT:
+                sx = moved;
+                break;
+            case LED_TRANSITION_SLIDE_RIGHT:
+                sx = LED_MATRIX_WIDTH - 1 - moved;
+                break;
+            case LED_TRANSITION_SLIDE_UP:
+                sy = moved;
+                break;
+            default:
+                sy = LED_MATRIX_HEIGHT - 1 - moved;
+                break;
             }
+            led_set_duty(frame, led_pixels[p], led_frame_pixel(source, sx, sy));
         }
     }
 }
 
-void led_putchar(uint8_t c)
+// Frame of a blend at progress t of 0 to 256. Every pixel is from + (to - from) x weight / 16 with a weight of 0 to
+// 16, the product taking at most 5 shift-add steps.
+static void led_transition_blend(const uint8_t *from, const uint8_t *to, uint8_t type, uint16_t t)
 {
-    uint32_t ch  = font[c - 27];
-    uint8_t *led = led_duty_cycles;
-    for (uint8_t line = 0; line < LED_MATRIX_NUM_PINS; line++)
+    const uint8_t *starts = led_transition_blends[type].starts;
+    uint8_t        shift  = led_transition_blends[type].shift;
+    uint8_t       *frame  = led_duty_cycles;
+    for (uint8_t p = 0; p < LED_MATRIX_SIZE; p++)
     {
-        for (uint8_t pixel = 0; pixel < LED_MATRIX_NUM_PINS - 1; pixel++)
+        uint8_t  led    = led_pixels[p];
+        uint8_t  a      = led_get_duty(from, led);
+        uint8_t  b      = led_get_duty(to, led);
+        uint16_t weight = (t > starts[p]) ? (t - starts[p]) >> shift : 0;
+        if (weight >= 16)
+        {
+            a = b;
+        }
+        else if (b >= a)
+        {
+            a += led_mul8(weight, b - a) >> 4;
+        }
+        else
         {
-            *led++ = (ch & 0x01) ? 16 : 0;
-            ch >>= 1;
+            a -= led_mul8(weight, a - b) >> 4;
         }
+        led_set_duty(frame, led, a);
     }
 }
 
-void led_show_array(const char *arr, uint8_t size)
+// Go from frame from to frame to over the given number of refresh frames, both in the layout of led_duty_cycles and
+// neither of them led_duty_cycles itself. The last frame is exactly to. The progress steps by 65536 / frames from the
+// reciprocal table, so there is no division.
+void led_transition(const uint8_t *from, const uint8_t *to, uint8_t type, uint8_t frames)
 {
-    for (uint8_t i = 0; i < size; i++)
+    uint32_t step     = (frames < 2) ? 0x10000 : led_reciprocals[frames];
+    uint32_t progress = 0;
+    for (uint8_t f = 0; f < frames; f++)
     {
-        led_putchar(arr[i]);
-        Delay_Ms(300);
+        progress += step;
+        uint16_t t = (progress >= 0x10000) ? 256 : progress >> 8;
+        if (type < LED_TRANSITION_BLENDS)
+        {
+            led_transition_blend(from, to, type, t);
+        }
+        else
+        {
+            led_transition_slide(from, to, type, t);
+        }
+#if LED_MATRIX_QUEUE
+        led_queue_push(1);
+#else
+        led_matrix_update();
+        led_wait_vsync();
+#endif
+        led_profile_poll();
     }
+#if LED_MATRIX_QUEUE
+    led_queue_wait();
+#endif
 }
 
 static inline void set_effect(uint8_t i)
 {
-    memcpy(led_duty_cycles, effects[i], LED_MATRIX_SIZE * sizeof(uint8_t));
+    led_show_brightness(led_effect(i));
 }
 
 int main()
@@ -293,6 +2322,9 @@ int main()
 
     // Init systick
     systick_init();
+#if LED_MATRIX_TIMER != LED_TIMER_SYSTICK
+    led_timer_init();
+#endif
 
     while (1)
     {
@@ -302,29 +2334,91 @@ int main()
         led_show_array(count_down, strlen(count_down));
 
         // Run effects
-        for (uint8_t e = 0; e < sizeof(effects) / sizeof(effects[0]); e++)
+        for (uint8_t e = 0; e < LED_EFFECTS; e++)
         {
             set_effect(e);
             for (uint8_t loop = 0; loop < LED_MATRIX_SIZE; loop++)
             {
+#if LED_MATRIX_SCROLL
+                // Rotate the LEDs by moving the scan origin, back to 0 after the last loop
+                led_scroll(loop == LED_MATRIX_SIZE - 1 ? 0 : loop + 1, 1);
+                led_wait_vsync();
+                Delay_Ms(50);
+#else
                 // Shuffle the LED duty cycles
-                uint8_t t = led_duty_cycles[0];
+                uint8_t *frame = led_duty_cycles;
+                uint8_t  t     = led_get_duty(frame, 0);
                 for (uint8_t i = 0; i < LED_MATRIX_SIZE - 1; i++)
                 {
-                    led_duty_cycles[i] = led_duty_cycles[i + 1];
+                    led_set_duty(frame, i, led_get_duty(frame, i + 1));
                 }
-                led_duty_cycles[LED_MATRIX_SIZE - 1] = t;
-
+                led_set_duty(frame, LED_MATRIX_SIZE - 1, t);
+#if LED_MATRIX_QUEUE
+                // Render ahead, the scan moves to the next frame every 50ms.
+                led_queue_push(LED_FRAMES_MS(50));
+#else
+                led_matrix_update();
+                led_wait_vsync();
                 Delay_Ms(50);
+#endif
+#endif
+                led_profile_poll();
+            }
+#if LED_MATRIX_QUEUE
+            led_queue_wait();
+#endif
+        }
+
+        // Procedural animations, 3s each
+        for (uint8_t a = 0; a < LED_ANIMATIONS; a++)
+        {
+            led_animation_run(a, LED_FRAMES_MS(3000));
+        }
+
+        // Streams from tools/stream_encoder, twice each
+        for (uint8_t i = 0; i < LED_STREAMS; i++)
+        {
+            led_stream_play(i, 2);
+        }
+
+        // Heart over the diagonal wave at quarter brightness
+        led_mask = led_glyph_mask(led_glyph('\x1b'));
+        for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+        {
+            led_layer_set(led_foreground, i, 255);
+        }
+        for (uint8_t loop = 0; loop < LED_MATRIX_SIZE; loop++)
+        {
+            for (uint8_t i = 0, j = loop; i < LED_MATRIX_SIZE; i++, j++)
+            {
+                if (j == LED_MATRIX_SIZE)
+                {
+                    j = 0;
+                }
+                led_layer_set(led_background, i, led_effect(LED_EFFECT_WAVE)[j] >> LED_LAYER_QUARTER);
             }
+            led_compose(LED_BLEND_REPLACE);
+
+            Delay_Ms(50);
+            led_profile_poll();
         }
 
         const char *msg[] = {"Hello", "World", "!!!!!", "LoveU", "Good ", "Night", "\x1b\x1b\x1b\x1b\x1b"};
-        for (uint8_t i = 0; i < 7; i++)
+        for (uint8_t i = 0, type = 0; i < sizeof(msg) / sizeof(msg[0]); i++)
         {
-            led_putchar(msg[i][BOARD]);
-            Delay_Ms(800);
+            // From the frame on display to the next character, a different transition each time
+            memcpy(led_background, led_duty_cycles, LED_FRAME_BYTES);
+            led_draw_char(msg[i][BOARD]);
+            memcpy(led_foreground, led_duty_cycles, LED_FRAME_BYTES);
+            led_transition(led_background, led_foreground, type, LED_FRAMES_MS(300));
+            type = (type == LED_TRANSITIONS - 1) ? 0 : type + 1;
+            Delay_Ms(500);
+            led_profile_poll();
         }
+        // The same text scrolling on every board, a column every 8 frames, about 13 columns a second
+        led_marquee_render("Hello World \xe2\x99\xa5", 1);
+        led_marquee_show(8);
+
         const char *end = "\x1f\x1e\x1d\x1c";
         led_show_array(end, strlen(end));
     }
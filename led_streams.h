@@ -0,0 +1,46 @@
+// Generated by tools/stream_encoder, run `make streams` instead of editing.
+
+// streams/heart.txt, 10 frames
+static const uint8_t led_stream_heart[] LED_ASSET = {
+    10,
+    0x04, 0x80, 0x43, 0x02, 0x02, 0x96, 0x97, 0x80, 0x92, 0x82, 0x90, 0x81,  // key 0
+    0x82, 0xb5, 0xb7, 0xb7, 0xb7,  // recolor 1
+    0x83, 0xfd, 0xff, 0xff, 0xff,  // recolor 2
+    0x82, 0xcd, 0xcf, 0xcf, 0xcf,  // recolor 3
+    0x83, 0xb5, 0xb7, 0xb7, 0xb7,  // recolor 4
+    0x83, 0xfd, 0xff, 0xff, 0xff,  // recolor 5
+    0x83, 0xcd, 0xcf, 0xcf, 0xcf,  // recolor 6
+    0x83, 0xb5, 0xb7, 0xb7, 0xb7,  // recolor 7
+    0x84, 0xa5, 0xa7, 0xa7, 0xa7,  // recolor 8
+    0x90, 0x95, 0x97, 0x97, 0x97,  // recolor 9
+};
+
+// streams/spinner.txt, 18 frames
+static const uint8_t led_stream_spinner[] LED_ASSET = {
+    18,
+    0x03, 0xf8, 0x83, 0xc0, 0x83, 0xa0, 0x83, 0x90, 0x83, 0x88, 0x80, 0x87,  // key 0
+    0x83, 0x41, 0xf8, 0xa3, 0x94, 0x8c, 0x84, 0x08,  // recolor 1
+    0x83, 0xa0, 0x41, 0xf8, 0x92, 0x8c, 0x84, 0x0d,  // recolor 2
+    0x03, 0x45, 0x42, 0xf8, 0x10, 0x84, 0x12,  // delta 3
+    0x03, 0x45, 0x21, 0x84, 0x0f, 0x17,  // delta 4
+    0x03, 0x80, 0x43, 0x21, 0x84, 0x03, 0xf8, 0x13,  // delta 5
+    0x83, 0x00, 0x43, 0x10, 0x42, 0xc7, 0x41, 0xf0, 0x0e,  // recolor 6
+    0x83, 0x82, 0x88, 0x90, 0xa4, 0xc7, 0x41, 0xf0, 0x09,  // recolor 7
+    0x83, 0x83, 0x88, 0x94, 0xa4, 0xc7, 0x41, 0xf0, 0x04,  // recolor 8
+    0x83, 0x84, 0x8c, 0x94, 0xa4, 0xc7, 0x41, 0xf0,  // recolor 9
+    0x83, 0x01, 0x87, 0x8c, 0x94, 0xa7, 0x41, 0x8f,  // recolor 10
+    0x83, 0x06, 0x87, 0x8c, 0x95, 0x43, 0xf0, 0x48,  // recolor 11
+    0x03, 0x0f, 0x87, 0x45, 0x01, 0x8f, 0x24,  // delta 12
+    0x03, 0x17, 0x45, 0xf0, 0x48, 0x12,  // delta 13
+    0x03, 0x13, 0xf8, 0x02, 0x45, 0x80, 0x24, 0x01,  // delta 14
+    0x83, 0x0d, 0x41, 0xf0, 0xc4, 0xa4, 0x90, 0x88, 0x81,  // recolor 15
+    0x83, 0x08, 0x41, 0xf0, 0xc4, 0xa4, 0x94, 0x88, 0x82,  // recolor 16
+    0x83, 0x03, 0x41, 0xf0, 0xc4, 0xa4, 0x94, 0x8c, 0x83,  // recolor 17
+};
+
+#define LED_STREAMS 2
+
+static const uint8_t *const led_streams[LED_STREAMS] LED_ASSET = {
+    led_stream_heart,
+    led_stream_spinner,
+};
@@ -0,0 +1,541 @@
+/*
+ * Font compiler, from a text-art or BDF font to the glyph tables of led_matrix.c
+ *
+ * Reads a 5x6 font and writes led_font.h: the glyphs in the bit order of the scan, where bit y * 5 + x lights pixel
+ * (x, y) of the cell, x from the left and y from the top, and the code point lookup of led_glyph_index(). The glyphs
+ * are encoded as 30-bit words (LED_FONT_FIXED) or as the lit columns of each glyph (LED_FONT_COLUMNS), whichever
+ * takes less flash unless -e picks one. Then reads the glyph tables back from led_font.h, prints the glyphs decoded
+ * from them the way led_glyph() does, and the size of both encodings.
+ *
+ *   font_compiler [-e fixed|columns] fonts/led_font.txt led_font.h
+ *
+ * Build and run with `make font`.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CELL_COLUMNS  5
+#define CELL_ROWS     6
+#define MAX_GLYPHS    255  // Glyph indexes are bytes, 0xff is none
+#define MAX_CODES     1024
+#define MAX_LINE      256
+#define BLANK_COLUMNS 2  // Columns of a blank glyph in the column encoding, LED_FONT_BLANK_COLUMNS
+#define OFFSET_BITS   13
+
+typedef struct
+{
+    uint32_t bits;  // Bit y * 5 + x lights pixel (x, y)
+    uint16_t code;  // First code point
+    char     name[48];
+} glyph;
+
+typedef struct
+{
+    uint16_t code;
+    uint8_t  glyph;
+} code_point;
+
+static glyph      glyphs[MAX_GLYPHS];
+static int        glyph_count;
+static code_point codes[MAX_CODES];
+static int        code_count;
+
+static const char *source;
+static int         line_number;
+
+static void fail(const char *message)
+{
+    fprintf(stderr, "%s:%d: %s\n", source, line_number, message);
+    exit(1);
+}
+
+static char *read_line(FILE *f, char *line)
+{
+    if (fgets(line, MAX_LINE, f) == NULL)
+    {
+        return NULL;
+    }
+    line_number++;
+    line[strcspn(line, "\r\n")] = 0;
+    return line;
+}
+
+static glyph *add_glyph(void)
+{
+    if (glyph_count == MAX_GLYPHS)
+    {
+        fail("too many glyphs");
+    }
+    return &glyphs[glyph_count++];
+}
+
+static void add_code(long code, int g)
+{
+    if (code < 0 || code > 0xffff)
+    {
+        fail("code point past U+FFFF");
+    }
+    for (int i = 0; i < code_count; i++)
+    {
+        if (codes[i].code == code)
+        {
+            fail("code point defined twice");
+        }
+    }
+    if (code_count == MAX_CODES)
+    {
+        fail("too many code points");
+    }
+    codes[code_count].code  = code;
+    codes[code_count].glyph = g;
+    code_count++;
+}
+
+// Text art: "U+0041 U+0391 name", then 6 lines of 5 pixels, '#' lit and '.' dark. Lines starting with // are comments.
+static void read_text(FILE *f)
+{
+    char line[MAX_LINE];
+    while (read_line(f, line) != NULL)
+    {
+        if (line[0] == 0 || strncmp(line, "//", 2) == 0)
+        {
+            continue;
+        }
+        if (strncmp(line, "U+", 2) != 0)
+        {
+            fail("expected a glyph header, U+ and the code point");
+        }
+
+        glyph *g     = add_glyph();
+        char  *p     = line;
+        int    first = code_count;
+        while (strncmp(p, "U+", 2) == 0)
+        {
+            char *end;
+            long  code = strtol(p + 2, &end, 16);
+            if (end == p + 2)
+            {
+                fail("bad code point");
+            }
+            add_code(code, g - glyphs);
+            p = end;
+            while (*p == ' ')
+            {
+                p++;
+            }
+        }
+        g->code = codes[first].code;
+        snprintf(g->name, sizeof(g->name), "%.47s", p);
+
+        for (int y = 0; y < CELL_ROWS; y++)
+        {
+            if (read_line(f, line) == NULL || strlen(line) != CELL_COLUMNS)
+            {
+                fail("expected a line of 5 pixels");
+            }
+            for (int x = 0; x < CELL_COLUMNS; x++)
+            {
+                if (line[x] == '#')
+                {
+                    g->bits |= 1UL << (y * CELL_COLUMNS + x);
+                }
+                else if (line[x] != '.')
+                {
+                    fail("pixels are '#' or '.'");
+                }
+            }
+        }
+    }
+}
+
+// BDF: every glyph with an ENCODING is placed in the cell by its BBX, with the baseline FONT_ASCENT rows down.
+static void read_bdf(FILE *f)
+{
+    char line[MAX_LINE];
+    int  ascent = CELL_ROWS;
+    char name[48];
+    long code   = -1;
+    int  w = 0, h = 0, xo = 0, yo = 0;
+    while (read_line(f, line) != NULL)
+    {
+        if (sscanf(line, "FONT_ASCENT %d", &ascent) == 1 || sscanf(line, "ENCODING %ld", &code) == 1 ||
+            sscanf(line, "BBX %d %d %d %d", &w, &h, &xo, &yo) == 4)
+        {
+            continue;
+        }
+        if (strncmp(line, "STARTCHAR ", 10) == 0)
+        {
+            snprintf(name, sizeof(name), "%.47s", line + 10);
+            code = -1;
+            continue;
+        }
+        if (strcmp(line, "BITMAP") != 0)
+        {
+            continue;
+        }
+
+        uint32_t bits = 0;
+        for (int r = 0; r < h; r++)
+        {
+            if (read_line(f, line) == NULL)
+            {
+                fail("BITMAP cut short");
+            }
+            unsigned long row   = strtoul(line, NULL, 16);
+            int           width = (int)strlen(line) * 4;
+            for (int c = 0; c < w; c++)
+            {
+                if (!((row >> (width - 1 - c)) & 1))
+                {
+                    continue;
+                }
+                int x = xo + c;
+                int y = ascent - yo - h + r;
+                if (x < 0 || x >= CELL_COLUMNS || y < 0 || y >= CELL_ROWS)
+                {
+                    fail("glyph does not fit the 5x6 cell");
+                }
+                bits |= 1UL << (y * CELL_COLUMNS + x);
+            }
+        }
+        if (code < 0)
+        {
+            continue;
+        }
+
+        glyph *g = add_glyph();
+        g->bits  = bits;
+        g->code  = code;
+        add_code(code, g - glyphs);
+        snprintf(g->name, sizeof(g->name), "%.47s", name);
+    }
+}
+
+// Lit columns of a glyph, bit y lights line y. Returns the width, and the first column in *left.
+static int glyph_columns(uint32_t bits, uint8_t *columns, int *left)
+{
+    uint8_t cell[CELL_COLUMNS] = {0};
+    for (int y = 0; y < CELL_ROWS; y++)
+    {
+        for (int x = 0; x < CELL_COLUMNS; x++)
+        {
+            cell[x] |= ((bits >> (y * CELL_COLUMNS + x)) & 1) << y;
+        }
+    }
+
+    int first = 0, last = CELL_COLUMNS;
+    while (first < CELL_COLUMNS && cell[first] == 0)
+    {
+        first++;
+    }
+    while (last > first && cell[last - 1] == 0)
+    {
+        last--;
+    }
+    if (first == last)
+    {
+        *left = 0;
+        memset(columns, 0, BLANK_COLUMNS);
+        return BLANK_COLUMNS;
+    }
+
+    *left = first;
+    memcpy(columns, &cell[first], last - first);
+    return last - first;
+}
+
+static const char *glyph_comment(const glyph *g)
+{
+    static char comment[64];
+    if (g->name[0] != 0)
+    {
+        snprintf(comment, sizeof(comment), "U+%04X %s", g->code, g->name);
+    }
+    else
+    {
+        snprintf(comment, sizeof(comment), "U+%04X '%c'", g->code, g->code);
+    }
+    return comment;
+}
+
+// Read the numbers of table name back from the written header, in order, returns how many
+static int read_table(const char *path, const char *name, uint32_t *values, int max)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        perror(path);
+        exit(1);
+    }
+    char line[MAX_LINE];
+    int  in = 0, n = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char *comment = strstr(line, "//");
+        if (comment != NULL)
+        {
+            *comment = 0;
+        }
+        if (!in)
+        {
+            char *p = strstr(line, name);
+            in      = p != NULL && p > line && p[-1] == ' ' && p[strlen(name)] == '[';
+            continue;
+        }
+        if (strncmp(line, "};", 2) == 0)
+        {
+            break;
+        }
+        for (char *p = line; *p != 0;)
+        {
+            if (p[0] != '0' || (p[1] != 'x' && p[1] != 'b'))
+            {
+                p++;
+                continue;
+            }
+            if (n == max)
+            {
+                fail("table read back is too long");
+            }
+            values[n++] = strtoul(p + 2, &p, (p[1] == 'x') ? 16 : 2);
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static int by_code(const void *a, const void *b)
+{
+    return ((const code_point *)a)->code - ((const code_point *)b)->code;
+}
+
+int main(int argc, char **argv)
+{
+    int encoding = -1;  // 0 fixed, 1 columns, -1 the smaller one
+    int arg      = 1;
+    if (argc == 5 && strcmp(argv[1], "-e") == 0)
+    {
+        encoding = strcmp(argv[2], "columns") == 0 ? 1 : strcmp(argv[2], "fixed") == 0 ? 0 : -2;
+        arg      = 3;
+    }
+    if (argc - arg != 2 || encoding == -2)
+    {
+        fprintf(stderr, "usage: %s [-e fixed|columns] font.txt|font.bdf led_font.h\n", argv[0]);
+        return 2;
+    }
+
+    source  = argv[arg];
+    FILE *f = fopen(source, "r");
+    if (f == NULL)
+    {
+        perror(source);
+        return 1;
+    }
+    char first_line[MAX_LINE];
+    int  bdf = fgets(first_line, sizeof(first_line), f) != NULL && strncmp(first_line, "STARTFONT", 9) == 0;
+    rewind(f);
+    if (bdf)
+    {
+        read_bdf(f);
+    }
+    else
+    {
+        read_text(f);
+    }
+    fclose(f);
+    line_number = 0;
+    if (glyph_count == 0)
+    {
+        fail("no glyphs");
+    }
+
+    // Glyphs from the first one on with consecutive code points are indexed directly, the other code points are
+    // looked up in blocks of 32.
+    int direct = 1;
+    while (direct < glyph_count && glyphs[direct].code == glyphs[0].code + direct)
+    {
+        direct++;
+    }
+    uint16_t   direct_first = glyphs[0].code;
+    uint16_t   direct_last  = direct_first + direct - 1;
+    code_point sparse[MAX_CODES];
+    int        sparse_count = 0;
+    for (int i = 0; i < code_count; i++)
+    {
+        uint16_t code = codes[i].code;
+        if (code < direct_first || code > direct_last || code - direct_first != codes[i].glyph)
+        {
+            sparse[sparse_count++] = codes[i];
+        }
+    }
+    qsort(sparse, sparse_count, sizeof(sparse[0]), by_code);
+    int map_size = sparse_count ? (sparse[sparse_count - 1].code >> 5) + 1 : 1;
+    int rows     = 0;
+    for (int i = 0; i < sparse_count; i++)
+    {
+        if (i == 0 || (sparse[i].code >> 5) != (sparse[i - 1].code >> 5))
+        {
+            rows++;
+        }
+    }
+
+    // Size of both encodings
+    uint8_t columns[MAX_GLYPHS * CELL_COLUMNS];
+    int     lefts[MAX_GLYPHS], offsets[MAX_GLYPHS + 1];
+    offsets[0] = 0;
+    for (int i = 0; i < glyph_count; i++)
+    {
+        offsets[i + 1] = offsets[i] + glyph_columns(glyphs[i].bits, &columns[offsets[i]], &lefts[i]);
+    }
+    int fixed_bytes   = glyph_count * 4;
+    int columns_bytes = offsets[glyph_count] + (glyph_count + 1) * 2;
+    if (encoding < 0)
+    {
+        encoding = columns_bytes < fixed_bytes;
+    }
+    if (offsets[glyph_count] >= (1 << OFFSET_BITS))
+    {
+        fail("too many columns for the column encoding");
+    }
+
+    FILE *out = fopen(argv[arg + 1], "w");
+    if (out == NULL)
+    {
+        perror(argv[arg + 1]);
+        return 1;
+    }
+    fprintf(out, "// Generated by tools/font_compiler from %s, run `make font` instead of editing.\n", source);
+    fprintf(out, "// %d glyphs, %d bytes as 30-bit words, %d bytes as columns.\n\n", glyph_count, fixed_bytes,
+            columns_bytes);
+    fprintf(out, "#define LED_FONT_ENCODING %s\n", encoding ? "LED_FONT_COLUMNS" : "LED_FONT_FIXED");
+    fprintf(out, "#define LED_FONT_GLYPHS   %d\n", glyph_count);
+    fprintf(out, "#define LED_FONT_FIRST    %d\n", direct_first);
+    fprintf(out, "#define LED_FONT_LAST     %d\n", direct_last);
+    fprintf(out, "#define LED_GLYPH_BLOCKS  %d\n\n", map_size);
+
+    if (encoding == 0)
+    {
+        fprintf(out, "static const uint32_t font[LED_FONT_GLYPHS] LED_ASSET = {\n");
+        for (int i = 0; i < glyph_count; i++)
+        {
+            fprintf(out, "    0b");
+            for (int b = 31; b >= 0; b--)
+            {
+                fputc('0' + ((glyphs[i].bits >> b) & 1), out);
+            }
+            fprintf(out, ",  // %s\n", glyph_comment(&glyphs[i]));
+        }
+        fprintf(out, "};\n\n");
+    }
+    else
+    {
+        fprintf(out, "static const uint16_t font_offsets[LED_FONT_GLYPHS + 1] LED_ASSET = {");
+        for (int i = 0; i <= glyph_count; i++)
+        {
+            int left = (i < glyph_count) ? lefts[i] : 0;
+            fprintf(out, "%s0x%04x,", (i % 10 == 0) ? "\n    " : " ", (left << OFFSET_BITS) | offsets[i]);
+        }
+        fprintf(out, "\n};\n\n");
+        fprintf(out, "static const uint8_t font_columns[] LED_ASSET = {\n");
+        for (int i = 0; i < glyph_count; i++)
+        {
+            fprintf(out, "   ");
+            for (int c = offsets[i]; c < offsets[i + 1]; c++)
+            {
+                fprintf(out, " 0x%02x,", columns[c]);
+            }
+            fprintf(out, "  // %s\n", glyph_comment(&glyphs[i]));
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    fprintf(out, "static const uint8_t led_glyph_map[LED_GLYPH_BLOCKS] LED_ASSET = {\n");
+    for (int i = 0, row = 0; i < sparse_count; i++)
+    {
+        if (i == 0 || (sparse[i].code >> 5) != (sparse[i - 1].code >> 5))
+        {
+            fprintf(out, "    [0x%04x >> 5] = %d,\n", sparse[i].code & ~0x1f, ++row);
+        }
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const uint8_t led_glyph_blocks[%d][32] LED_ASSET = {\n", rows ? rows : 1);
+    for (int i = 0; i < sparse_count; i++)
+    {
+        if (i == 0 || (sparse[i].code >> 5) != (sparse[i - 1].code >> 5))
+        {
+            fprintf(out, "%s    {\n", i ? "    },\n" : "");
+        }
+        const int    index = sparse[i].glyph;
+        const glyph *g     = &glyphs[index];
+        fprintf(out, "        LED_GLYPH_AT(0x%04x, %d),%*s// ", sparse[i].code, index,
+                (index < 10) ? 4 : (index < 100) ? 3 : 2, "");
+        if (g->code != sparse[i].code)
+        {
+            fprintf(out, "U+%04X as ", sparse[i].code);
+        }
+        fprintf(out, "%s\n", glyph_comment(g));
+    }
+    fprintf(out, "%s};\n", sparse_count ? "    },\n" : "");
+    fclose(out);
+
+    // Tables as written
+    static uint32_t table_words[MAX_GLYPHS], table_offsets[MAX_GLYPHS + 1], table_columns[MAX_GLYPHS * CELL_COLUMNS];
+    if (encoding == 0 ? read_table(argv[arg + 1], "font", table_words, MAX_GLYPHS) != glyph_count
+                      : read_table(argv[arg + 1], "font_offsets", table_offsets, MAX_GLYPHS + 1) != glyph_count + 1 ||
+                            read_table(argv[arg + 1], "font_columns", table_columns, MAX_GLYPHS * CELL_COLUMNS) !=
+                                offsets[glyph_count])
+    {
+        fail("glyph table read back is not the size written");
+    }
+
+    // Preview decoded from the tables read back, ten a row
+    for (int i = 0; i < glyph_count; i += 10)
+    {
+        int n = (glyph_count - i < 10) ? glyph_count - i : 10;
+        for (int k = 0; k < n; k++)
+        {
+            printf("%04X   ", glyphs[i + k].code);
+        }
+        printf("\n");
+        for (int y = 0; y < CELL_ROWS; y++)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                const int g    = i + k;
+                uint32_t  bits = 0;
+                if (encoding == 0)
+                {
+                    bits = table_words[g];
+                }
+                else
+                {
+                    int x = table_offsets[g] >> OFFSET_BITS;
+                    for (int c = table_offsets[g] & ((1 << OFFSET_BITS) - 1);
+                         c < (int)(table_offsets[g + 1] & ((1 << OFFSET_BITS) - 1)); c++, x++)
+                    {
+                        for (int r = 0; r < CELL_ROWS; r++)
+                        {
+                            bits |= (uint32_t)((table_columns[c] >> r) & 1) << (r * CELL_COLUMNS + x);
+                        }
+                    }
+                }
+                for (int x = 0; x < CELL_COLUMNS; x++)
+                {
+                    putchar((bits >> (y * CELL_COLUMNS + x)) & 1 ? '#' : '.');
+                }
+                printf("  ");
+            }
+            printf("\n");
+        }
+        printf("\n");
+    }
+
+    printf("%d glyphs, characters %d to %d indexed directly, %d code points in %d blocks of 32\n", glyph_count,
+           direct_first, direct_last, sparse_count, rows);
+    printf("30-bit words: %d bytes, columns: %d bytes, lookup: %d bytes, %s encoding written to %s\n", fixed_bytes,
+           columns_bytes, map_size + (rows ? rows : 1) * 32, encoding ? "column" : "30-bit", argv[arg + 1]);
+    return 0;
+}
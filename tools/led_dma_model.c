@@ -0,0 +1,153 @@
+/*
+ * Host model of the DMA refresh (LED_TIMER_DMA)
+ *
+ * Replays the DMA tables tick by tick the way TIM1, TIM2 and the DMA channels copy them into the port registers, and
+ * works out the lit LEDs from the pin states of every tick: an LED is lit while its row pin is an output driven low and
+ * its column pin an output driven high. Over a frame each LED must be lit for as many ticks as its duty cycle, the
+ * expectation comes straight from the duty cycles, not from the port tables the DMA table is built from.
+ *
+ * Build and run with `make dma_model`, add `-v` to print the pins of every tick of the first frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch32v003fun.h"
+
+// The scan the DMA refresh supports, whatever funconfig.h selects
+#undef LED_MATRIX_SCAN_ROWS
+#undef LED_MATRIX_PORT_TABLES
+#undef LED_MATRIX_PWM
+#undef LED_MATRIX_SKIP_DARK
+#undef LED_MATRIX_TIMER
+#define LED_MATRIX_SCAN_ROWS   1
+#define LED_MATRIX_PORT_TABLES 1
+#define LED_MATRIX_PWM         LED_PWM_LINEAR
+#define LED_MATRIX_SKIP_DARK   LED_SKIP_DARK_OFF
+#define LED_MATRIX_TIMER       LED_TIMER_DMA
+
+// Port A, C and D in host memory
+static GPIO_TypeDef model_ports[3];
+#undef GPIOA
+#undef GPIOC
+#undef GPIOD
+#define GPIOA (&model_ports[0])
+#define GPIOC (&model_ports[1])
+#define GPIOD (&model_ports[2])
+
+// RISC-V interrupt handlers build as plain functions on the host.
+#define interrupt used
+#define main      led_matrix_main
+#include "../led_matrix.c"
+#undef main
+
+void SystemInit(void) {}
+void DelaySysTick(uint32_t n) {}
+
+// Port words after a tick
+typedef struct
+{
+    uint32_t cfglr[LED_PORTS];
+    uint32_t bshr[LED_PORTS];
+} model_tick;
+
+static model_tick dma[LED_DMA_TICKS];
+
+// Pin state as 'L' (output low), 'H' (output high) or '-' (floating or not set by BSHR)
+static char model_pin(const model_tick *t, uint8_t pin)
+{
+    uint8_t  x   = LED_PORT_INDEX(pin);
+    uint8_t  n   = GPIOv_to_PIN(pin);
+    uint32_t cfg = (t->cfglr[x] >> (4 * n)) & 0xf;
+    if ((cfg & 0x3) == 0 || (cfg & 0xc) != GPIO_CNF_OUT_PP)
+    {
+        return '-';
+    }
+    return (t->bshr[x] & (1 << n)) ? 'H' : (t->bshr[x] & (1 << (16 + n))) ? 'L' : '-';
+}
+
+// Count a tick for every lit LED, LED row * 5 + column has its cathode on pin row and its anode on the column-th of
+// the other pins.
+static void model_lit(const model_tick *t, uint16_t *on)
+{
+    for (uint8_t row = 0; row < LED_MATRIX_NUM_PINS; row++)
+    {
+        if (model_pin(t, pins[row]) != 'L')
+        {
+            continue;
+        }
+        for (uint8_t p = 0; p < LED_MATRIX_NUM_PINS; p++)
+        {
+            if (p != row && model_pin(t, pins[p]) == 'H')
+            {
+                on[row * (LED_MATRIX_NUM_PINS - 1) + p - (p > row)]++;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    // Other pins of the ports as after reset
+    for (uint8_t x = 0; x < LED_PORTS; x++)
+    {
+        led_cfglr_base[x] = 0x44444444 & ~LED_PORT_MASK(x);
+    }
+
+    srand(1);
+    int errors = 0;
+    for (int frame = 0; frame < 100; frame++)
+    {
+        uint8_t duty[LED_MATRIX_SIZE];
+        for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+        {
+            duty[i] = (frame == 0) ? led_gamma[led_effect(LED_EFFECT_WAVE)[i]] : rand() % (LED_DUTY_MAX + 1);
+            led_set_duty(led_duty_cycles, i, duty[i]);
+        }
+        led_dma_build();
+
+        // DMA, the first tick is written by led_timer_init(), then every TIM1 update copies the next CFGLR words and
+        // every TIM2 update the next BSHR words.
+        for (uint16_t t = 0; t < LED_DMA_TICKS; t++)
+        {
+            uint16_t i = (t == 0) ? LED_DMA_TICKS - 1 : t - 1;
+            uint8_t  s = t / LED_PWM_CYCLES;
+            for (uint8_t x = 0; x < LED_PORTS; x++)
+            {
+                dma[t].cfglr[x] = led_dma_cfglr[x][i];
+                dma[t].bshr[x]  = led_dma_bshr[x][(s == 0) ? LED_SLOTS - 1 : s - 1];
+            }
+        }
+
+        uint16_t on[LED_MATRIX_SIZE] = {0};
+        for (uint16_t t = 0; t < LED_DMA_TICKS; t++)
+        {
+            model_lit(&dma[t], on);
+            if (verbose && frame == 0)
+            {
+                printf("tick %2u slot %u  ", t, t / LED_PWM_CYCLES);
+                for (uint8_t p = 0; p < LED_MATRIX_NUM_PINS; p++)
+                {
+                    putchar(model_pin(&dma[t], pins[p]));
+                }
+                putchar('\n');
+            }
+        }
+
+        for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+        {
+            if (on[i] != duty[i])
+            {
+                printf("frame %d: LED %u lit for %u ticks, duty cycle %u\n", frame, i, on[i], duty[i]);
+                errors++;
+            }
+        }
+    }
+
+    printf("DMA table: %u ticks x %u ports, %u bytes of RAM, %d LEDs off their duty cycle in 100 frames\n",
+           LED_DMA_TICKS, LED_PORTS, (unsigned)sizeof(led_dma_cfglr), errors);
+    return errors != 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Host check of the fixed-point math of led_math.h
+ *
+ * Runs every 8-bit input of each function against plain arithmetic, or libm for the sine, and prints the largest
+ * error. The host has a multiplier, so the cycles are measured on the chip instead, type 'm' in `make monitor` with
+ * LED_MATRIX_PROFILE.
+ *
+ * Build and run with `make math_check`.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../led_math.h"
+
+static int errors;
+
+static void check(const char *name, int max_error, int tolerance, long inputs)
+{
+    printf("%-16s %6ld inputs, max error %d\n", name, inputs, max_error);
+    if (max_error > tolerance)
+    {
+        printf("%s: over the tolerance of %d\n", name, tolerance);
+        errors++;
+    }
+}
+
+// The larger of e and the error of got
+static int worst(int e, int got, int want)
+{
+    int d = abs(got - want);
+    return (d > e) ? d : e;
+}
+
+int main()
+{
+    int  e;
+    long n;
+
+    // Sine against libm, the table is rounded to 1/255
+    e = 0;
+    for (int a = 0; a < 256; a++)
+    {
+        int want = (int)lround(sin(a * M_PI / 128) * 255);
+        e        = worst(e, led_sin(a), want);
+        e        = worst(e, led_cos(a), (int)lround(cos(a * M_PI / 128) * 255));
+        e        = worst(e, led_wave8(a), (255 + want) >> 1);
+    }
+    check("sin cos wave8", e, 0, 256);
+
+    // Constant multiply, the constant only folds at compile time but the macro gives the same result for any k
+    e = 0;
+    n = 0;
+    for (int k = 0; k < 256; k++)
+    {
+        for (int x = 0; x < 256; x++, n++)
+        {
+            e = worst(e, LED_MUL_K(x, k), x * k);
+            e = worst(e, led_mul8(x, k), x * k);
+        }
+    }
+    check("mul_k mul8", e, 0, n);
+
+    // Division and remainder, the reciprocal is exact for 8-bit dividends
+    e = 0;
+    n = 0;
+    for (int d = 1; d < 256; d++)
+    {
+        for (int x = 0; x < 256; x++, n++)
+        {
+            e = worst(e, led_div8(x, d), x / d);
+            e = worst(e, led_mod8(x, d), x % d);
+        }
+    }
+    for (int x = 0; x < 256; x++)
+    {
+        e = worst(e, led_div8(x, 0), 0);
+        e = worst(e, led_mod8(x, 0), x);
+    }
+    check("div8 mod8", e, 0, n);
+
+    // Scale and lerp, both ends exact
+    e = 0;
+    n = 0;
+    for (int t = 0; t < 256; t++)
+    {
+        for (int x = 0; x < 256; x++)
+        {
+            e = worst(e, led_scale8(x, t), x * (t + 1) / 256);
+            for (int b = 0; b < 256; b += 15, n++)
+            {
+                int want = x + (b - x) * (t + 1) / 256;
+                e        = worst(e, led_lerp8(x, b, t), want);
+            }
+            e = worst(e, led_lerp8(x, 255 - x, 0), x);
+            e = worst(e, led_lerp8(x, 255 - x, 255), 255 - x);
+        }
+    }
+    check("scale8 lerp8", e, 0, n);
+
+    // Easing against the exact curves, off by the truncation of the 8-bit steps
+    e = 0;
+    for (int t = 0; t < 256; t++)
+    {
+        double f = t / 255.0;
+        e        = worst(e, led_ease_in8(t), (int)lround(f * f * 255));
+        e        = worst(e, led_ease_out8(t), (int)lround((1 - (1 - f) * (1 - f)) * 255));
+        double g = (f < 0.5) ? 2 * f * f : 1 - 2 * (1 - f) * (1 - f);
+        e        = worst(e, led_ease_in_out8(t), (int)lround(g * 255));
+    }
+    e = worst(e, led_ease_in8(0) | led_ease_out8(0) | led_ease_in_out8(0), 0);
+    e = worst(e, led_ease_in8(255) & led_ease_out8(255) & led_ease_in_out8(255), 255);
+    check("ease", e, 2, 256);
+
+    printf("%d failed\n", errors);
+    return errors != 0;
+}
@@ -0,0 +1,402 @@
+/*
+ * Host model of the LED matrix scan
+ *
+ * Runs led_matrix_run() step by step on model GPIO ports and works out the lit LEDs from the pin states after every
+ * step: an LED is lit while its row pin is an output driven low and its column pin an output driven high. Each LED
+ * must then be on for its duty cycle times the PWM unit over a frame, whatever the scan, PWM engine or port writes,
+ * and the frame must keep its length. The expectation comes straight from the duty cycles, not from the scan tables.
+ *
+ * Steps shorter than LED_MIN_IRQ_CYCLES are waited out in the ISR with the BAM and event PWM, so the model counts an
+ * interrupt for every step that follows a longer one, and prints the interrupts a second.
+ *
+ * With LED_TIMER_TIM1 or LED_TIMER_TIM2 and the linear PWM, the model calls the timer ISR on a model timer instead,
+ * so the 16-bit compare and the split of long steps are checked too. The BAM and event PWM wait out short steps on
+ * the counter inside the ISR, which the model cannot run, so with them it calls led_matrix_run() as for SysTick.
+ *
+ * With LED_MATRIX_SCROLL, every frame scrolls to a random origin with or without wrap, and the LEDs must show the
+ * duty cycles moved by it. With LED_MATRIX_QUEUE, the frames are queued by led_queue_push() to be shown for 0 to 3
+ * frames each instead of swapped in by led_matrix_update(), and each must be on display for exactly that many frames.
+ *
+ * The configuration is funconfig.h with the MODEL_* overrides below, `make scan_model` builds and runs each one.
+ * With `-d` the model prints the on-time of every LED in PWM units, one frame a line, so two builds can be compared.
+ *
+ *   cc -DMODEL_SCAN_ROWS=1 -DMODEL_PWM=LED_PWM_BAM -DMODEL_PWM_BITS=8 ... tools/led_scan_model.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch32v003fun.h"
+#include "ch32v003_GPIO_branchless.h"
+
+// The scan to model, funconfig.h unless set on the command line
+#ifdef MODEL_SCAN_ROWS
+#undef LED_MATRIX_SCAN_ROWS
+#define LED_MATRIX_SCAN_ROWS MODEL_SCAN_ROWS
+#endif
+#ifdef MODEL_PORT_TABLES
+#undef LED_MATRIX_PORT_TABLES
+#define LED_MATRIX_PORT_TABLES MODEL_PORT_TABLES
+#endif
+#ifdef MODEL_PWM
+#undef LED_MATRIX_PWM
+#define LED_MATRIX_PWM MODEL_PWM
+#endif
+#ifdef MODEL_PWM_BITS
+#undef LED_MATRIX_PWM_BITS
+#define LED_MATRIX_PWM_BITS MODEL_PWM_BITS
+#endif
+#ifdef MODEL_SKIP_DARK
+#undef LED_MATRIX_SKIP_DARK
+#define LED_MATRIX_SKIP_DARK MODEL_SKIP_DARK
+#endif
+#ifdef MODEL_PACKED
+#undef LED_MATRIX_PACKED
+#define LED_MATRIX_PACKED MODEL_PACKED
+#endif
+#ifdef MODEL_TIMER
+#undef LED_MATRIX_TIMER
+#define LED_MATRIX_TIMER MODEL_TIMER
+#endif
+
+// The scroll origin and the frame queue are off unless set on the command line.
+#undef LED_MATRIX_SCROLL
+#ifdef MODEL_SCROLL
+#define LED_MATRIX_SCROLL MODEL_SCROLL
+#else
+#define LED_MATRIX_SCROLL 0
+#endif
+#undef LED_MATRIX_QUEUE
+#ifdef MODEL_QUEUE
+#define LED_MATRIX_QUEUE MODEL_QUEUE
+#else
+#define LED_MATRIX_QUEUE 0
+#endif
+
+// The model does not care how long the ISR takes.
+#undef LED_MATRIX_ISR_BUDGET
+#undef LED_MATRIX_PROFILE
+#define LED_MATRIX_ISR_BUDGET 100
+#define LED_MATRIX_PROFILE    0
+
+// Port A, C and D in host memory, by GPIO_port_n. BSHR writes are applied to OUTDR after every step, the pin by pin
+// writes of LED_MATRIX_PORT_TABLES 0 go straight to OUTDR as there can be several to a port in a step.
+static GPIO_TypeDef model_ports[4];
+#undef GPIOA
+#undef GPIOC
+#undef GPIOD
+#define GPIOA (&model_ports[GPIO_port_A])
+#define GPIOC (&model_ports[GPIO_port_C])
+#define GPIOD (&model_ports[GPIO_port_D])
+#undef GPIOv_to_GPIObase
+#define GPIOv_to_GPIObase(v) (&model_ports[GPIOv_to_PORT(v)])
+#undef GPIO_digitalWrite_hi
+#undef GPIO_digitalWrite_lo
+#define GPIO_digitalWrite_hi(v) (GPIOv_to_GPIObase(v)->OUTDR |= 1 << GPIOv_to_PIN(v))
+#define GPIO_digitalWrite_lo(v) (GPIOv_to_GPIObase(v)->OUTDR &= ~(1 << GPIOv_to_PIN(v)))
+
+// TIM1 and TIM2 in host memory, the ISR only moves the compare of channel 1.
+static TIM_TypeDef model_timer __attribute__((unused));
+#undef TIM1
+#undef TIM2
+#define TIM1 (&model_timer)
+#define TIM2 (&model_timer)
+
+// led_matrix.c sets the timer clock before it includes ch32v003_GPIO_branchless.h, which is included here already.
+#undef GPIO_timer_prescaler
+#undef GPIO_timer_resolution
+
+// RISC-V interrupt handlers build as plain functions on the host.
+#define interrupt used
+#define main      led_matrix_main
+#include "../led_matrix.c"
+#undef main
+
+#if LED_MATRIX_TIMER == LED_TIMER_DMA
+#error "The DMA refresh has no scan steps, `make dma_model` checks it"
+#endif
+
+void SystemInit(void) {}
+void DelaySysTick(uint32_t n) {}
+
+// Run a scan step, returns the cycles until the next one.
+static uint32_t model_step()
+{
+#if LED_MATRIX_TIMER != LED_TIMER_SYSTICK && LED_MATRIX_PWM == LED_PWM_LINEAR
+    // The compare has matched, the step lasts until the compare the ISR sets.
+    uint16_t now = LED_TIM->CH1CVR;
+    LED_TIM->CNT = now;
+    LED_TIM_IRQHandler();
+    uint32_t cycles = (uint16_t)(LED_TIM->CH1CVR - now);
+#else
+    uint32_t cycles = led_matrix_run();
+#endif
+    for (uint8_t x = 0; x < 4; x++)
+    {
+        GPIO_TypeDef *port = &model_ports[x];
+        port->OUTDR        = (port->OUTDR | (port->BSHR & 0xffff)) & ~(port->BSHR >> 16);
+        port->BSHR         = 0;
+    }
+    return cycles;
+}
+
+// 1 if pin is an output driven at level
+static int model_pin_is(uint8_t pin, uint8_t level)
+{
+    const GPIO_TypeDef *port = GPIOv_to_GPIObase(pin);
+    uint32_t            cfg  = (port->CFGLR >> (4 * GPIOv_to_PIN(pin))) & 0xf;
+    return (cfg & 0x3) != 0 && (cfg & 0xc) == GPIO_CNF_OUT_PP && ((port->OUTDR >> GPIOv_to_PIN(pin)) & 1) == level;
+}
+
+// Add cycles to the on-time of every lit LED, LED row * 5 + column has its cathode on pin row and its anode on the
+// column-th of the other pins.
+static void model_lit(uint32_t *on, uint32_t cycles)
+{
+    for (uint8_t row = 0; row < LED_MATRIX_NUM_PINS; row++)
+    {
+        if (!model_pin_is(pins[row], 0))
+        {
+            continue;
+        }
+        for (uint8_t p = 0; p < LED_MATRIX_NUM_PINS; p++)
+        {
+            if (p != row && model_pin_is(pins[p], 1))
+            {
+                on[row * (LED_MATRIX_NUM_PINS - 1) + p - (p > row)] += cycles;
+            }
+        }
+    }
+}
+
+static int      dump;
+static int      errors;
+static int      checked;  // Frames checked
+static uint32_t irqs;
+static uint32_t cycles;
+
+// Run steps until the next frame start
+static void model_frame_start()
+{
+    uint32_t count = led_frame_count;
+    while (led_frame_count == count)
+    {
+        cycles = model_step();
+    }
+}
+
+// Random duty cycles, the more LEDs lit the higher frame % 5, all of them full for 4
+static void model_duty(int frame, uint8_t *duty)
+{
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+    {
+        if (frame % 5 == 4)
+        {
+            duty[i] = LED_DUTY_MAX;
+        }
+        else
+        {
+            duty[i] = (rand() % 4 < frame % 5) ? 1 + rand() % LED_DUTY_MAX : 0;
+        }
+    }
+}
+
+// Scroll from the next frame start on, to a random origin with or without wrap
+static void model_scroll(uint8_t *origin, uint8_t *wrap)
+{
+    *origin = 0;
+    *wrap   = 1;
+#if LED_MATRIX_SCROLL
+    *origin = rand() % (3 * LED_MATRIX_SIZE);
+    *wrap   = rand() % 2;
+    led_scroll(*origin, *wrap);
+#endif
+}
+
+// What LED i should show of duty as shown[i] when scrolled to origin: LED i + origin, modulo LED_MATRIX_SIZE with wrap
+// and dark past the last LED without it
+static void model_shown(const uint8_t *duty, uint8_t origin, uint8_t wrap, uint8_t *shown)
+{
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+    {
+        int led  = wrap ? (i + origin) % LED_MATRIX_SIZE : i + origin;
+        shown[i] = (led < LED_MATRIX_SIZE) ? duty[led] : 0;
+    }
+}
+
+// Run the frame that has just started and check that it shows the duty cycles shown
+static void model_check(int frame, const uint8_t *shown)
+{
+    // Lit slots and the PWM unit the frame should have
+    uint8_t lit = 0;
+    for (uint8_t s = 0; s < LED_SLOTS; s++)
+    {
+        for (uint8_t i = 0; i < LED_SLOT_COLUMNS; i++)
+        {
+            if (shown[s * LED_SLOT_COLUMNS + i] != 0)
+            {
+                lit++;
+                break;
+            }
+        }
+    }
+    uint32_t unit         = LED_UNIT_CYCLES;
+    uint32_t frame_cycles = LED_FRAME_CYCLES;
+#if LED_MATRIX_SKIP_DARK == LED_SKIP_DARK_FRAME
+    if (lit != 0)
+    {
+        unit         = LED_UNIT_CYCLES * LED_SLOTS / lit;
+        frame_cycles = unit * LED_PWM_MAX * lit;
+    }
+#endif
+
+    // Every step until the next frame start
+    uint32_t on[LED_MATRIX_SIZE] = {0};
+    uint32_t total               = 0;
+    uint32_t count               = led_frame_count;
+    checked++;
+    while (led_frame_count == count)
+    {
+        model_lit(on, cycles);
+        total += cycles;
+        irqs += LED_MATRIX_PWM == LED_PWM_LINEAR || cycles >= LED_MIN_IRQ_CYCLES;
+        cycles = model_step();
+    }
+
+    if (total != frame_cycles)
+    {
+        printf("frame %d: %u cycles, %u expected\n", frame, total, frame_cycles);
+        errors++;
+    }
+    for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+    {
+        if (on[i] != shown[i] * unit)
+        {
+            printf("frame %d: LED %u on for %u cycles, %u expected\n", frame, i, on[i], shown[i] * unit);
+            errors++;
+        }
+        if (dump)
+        {
+            printf("%u%c", on[i] / unit, (i == LED_MATRIX_SIZE - 1) ? '\n' : ' ');
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    dump = argc > 1 && strcmp(argv[1], "-d") == 0;
+
+    // Pins after reset, floating inputs
+    for (uint8_t x = 0; x < 4; x++)
+    {
+        model_ports[x].CFGLR = 0x44444444;
+    }
+#if LED_MATRIX_PORT_TABLES
+    for (uint8_t x = 0; x < LED_PORTS; x++)
+    {
+        led_cfglr_base[x] = 0x44444444 & ~LED_PORT_MASK(x);
+    }
+#endif
+
+    srand(1);
+    cycles = model_step();
+    uint8_t shown[LED_MATRIX_SIZE];
+#if LED_MATRIX_QUEUE
+    // 100 frames shown for 0 to 3 frames each. The scan skips frames of 0 frames, unless nothing is queued after them,
+    // so there are no two in a row for the queue to always hold the frame after them, and none with a queue of 2.
+    // The last frame stays on display once its frames are up.
+    uint8_t frames[100][LED_MATRIX_SIZE], hold[100];
+    for (int frame = 0; frame < 100; frame++)
+    {
+        model_duty(frame, frames[frame]);
+        int zero    = LED_MATRIX_QUEUE > 2 && frame != 99 && (frame == 0 || hold[frame - 1] != 0);
+        hold[frame] = zero ? rand() % 4 : 1 + rand() % 3;
+    }
+
+    // Queue the frames as far ahead as the queue takes after every frame start, led_queue_push() would wait for the
+    // ISR when it is full, and check every frame shown until the scan has shown the last one for its frames.
+    int     pushed = 0, frame = 0, left = 0;
+    uint8_t origin, wrap;
+    while (1)
+    {
+        while (pushed < 100 && (led_queue.head + 1) % LED_MATRIX_QUEUE != led_queue.tail)
+        {
+            for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+            {
+                led_set_duty(led_duty_cycles, i, frames[pushed][i]);
+            }
+            led_queue_push(hold[pushed++]);
+        }
+        if (frame == 0)
+        {
+            model_scroll(&origin, &wrap);
+            model_frame_start();
+        }
+
+        // The frame on display is the next frame queued for 1 frame or more.
+        while (left == 0 && frame < 100)
+        {
+            left = hold[frame++];
+        }
+        if (left == 0)
+        {
+            printf("frame %d: shown for more than %u frames\n", frame - 1, hold[frame - 1]);
+            errors++;
+            break;
+        }
+        left--;
+        model_shown(frames[frame - 1], origin, wrap, shown);
+        model_scroll(&origin, &wrap);
+        model_check(frame - 1, shown);
+        if (led_queue.tail == led_queue.head && led_queue.wait == 0)
+        {
+            break;
+        }
+    }
+
+    if (frame != 100 || left != 0)
+    {
+        printf("frame %d: queue ran dry with %d frames left to show\n", frame - 1, left);
+        errors++;
+    }
+#else
+    for (int frame = 0; frame < 100; frame++)
+    {
+        // The diagonal wave, then frames from dark to full with every kind of duty cycle
+        uint8_t duty[LED_MATRIX_SIZE];
+        if (frame == 0)
+        {
+            for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+            {
+                duty[i] = led_gamma[led_effect(LED_EFFECT_WAVE)[i]];
+            }
+        }
+        else
+        {
+            model_duty(frame, duty);
+        }
+        for (uint8_t i = 0; i < LED_MATRIX_SIZE; i++)
+        {
+            led_set_duty(led_duty_cycles, i, duty[i]);
+        }
+        uint8_t origin, wrap;
+        model_scroll(&origin, &wrap);
+        model_shown(duty, origin, wrap, shown);
+        led_matrix_update();
+
+        // The new frame is shown from the next frame start on.
+        model_frame_start();
+        model_check(frame, shown);
+    }
+#endif
+
+    if (!dump)
+    {
+        printf("%s scan, PWM %u, %u bits, skip dark %u, packed %u, port tables %u, timer %u, scroll %u, queue %u: %u "
+               "interrupts a second, %d errors in %d frames\n",
+               LED_MATRIX_SCAN_ROWS ? "Row" : "One-LED", LED_MATRIX_PWM, LED_MATRIX_PWM_BITS, LED_MATRIX_SKIP_DARK,
+               LED_MATRIX_PACKED, LED_MATRIX_PORT_TABLES, LED_MATRIX_TIMER, LED_MATRIX_SCROLL, LED_MATRIX_QUEUE,
+               irqs * LED_MATRIX_REFRESH_HZ / checked, errors, checked);
+    }
+    return errors != 0;
+}
@@ -0,0 +1,41 @@
+# RAM used by each variable, from the symbol table the build writes to the .map file (objdump -t)
+#
+#   make ram
+#
+# A symbol line is "address flags section<TAB>size name", the variables are the objects in .data and .bss. The
+# objects in .assets stay in flash and are only added up.
+
+function hex(s,    i, n) {
+    n = 0
+    s = tolower(s)
+    for (i = 1; i <= length(s); i++) {
+        n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+    }
+    return n
+}
+
+BEGIN { FS = "\t" }
+
+{
+    k = split($1, head, " ")
+    if (k < 2 || head[k - 1] != "O") {
+        next
+    }
+    split($2, tail, " ")
+    size = hex(tail[1])
+    if (head[k] == ".assets") {
+        assets += size
+        next
+    }
+    if (head[k] !~ /^\.s?(data|bss)/) {
+        next
+    }
+    total += size
+    printf "%6d  %-6s %s\n", size, head[k], tail[2] | "sort -rn"
+}
+
+END {
+    close("sort -rn")
+    printf "%6d  bytes of RAM in variables\n", total
+    printf "%6d  bytes of assets read from flash\n", assets
+}
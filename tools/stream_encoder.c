@@ -0,0 +1,323 @@
+/*
+ * Animation stream encoder, from text-art frames to the streams of led_stream_next()
+ *
+ * Reads frames of 30 pixels with a brightness level of 0 to 15 each and writes led_streams.h. The first frame is a
+ * keyframe that sets every pixel, the others only encode the pixels that changed since the frame before. A frame is a
+ * header byte, then tokens over the pixels in order until all 30 are covered:
+ *  - 00nnnnnn: skip n + 1 pixels, they keep the level of the frame before
+ *  - 01nnnnnn: n + 1 literal levels follow, two a byte, the first one in the low nibble
+ *  - 1llllnnn: n + 1 pixels of level l
+ * The header holds the refresh frames to show the frame for, 1 to 127, and the recolor flag (0x80). With the flag, runs
+ * only set the pixels lit in the frame before and the dark ones stay dark, so a shape fading or pulsing takes a token
+ * per 8 pixels. The stream starts with the number of frames. Each frame is encoded with the fewest bytes, then
+ * decoded back and checked against the source, and the size is printed against 30 bytes a frame as in effects[].
+ *
+ *   stream_encoder led_streams.h streams/heart.txt streams/spinner.txt
+ *
+ * Build and run with `make streams`.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIXELS      30
+#define MAX_FRAMES  255
+#define MAX_STREAMS 16
+#define MAX_LINE    256
+#define MAX_BYTES   (MAX_FRAMES * PIXELS * 2 + 1)
+
+// Tokens, as decoded by led_stream_next()
+#define TOKEN_SKIP    0x00
+#define TOKEN_LITERAL 0x40
+#define TOKEN_RUN     0x80
+#define RECOLOR       0x80  // Header flag
+#define MAX_HOLD      127
+#define MAX_COUNT     64  // Skip and literal
+#define MAX_RUN       8
+
+typedef struct
+{
+    uint8_t hold;
+    uint8_t levels[PIXELS];
+} frame;
+
+static frame frames[MAX_FRAMES];
+static int   frame_count;
+
+static const char *source;
+static int         line_number;
+
+static void fail(const char *message)
+{
+    fprintf(stderr, "%s:%d: %s\n", source, line_number, message);
+    exit(1);
+}
+
+// Frames of a text-art file: "frame <hold>", then the pixels row by row, '.' or a hex digit for the level. The rows
+// are the matrix as mounted, 5 pixels by 6 or 6 by 5. "//" starts a comment.
+static void read_frames(FILE *f)
+{
+    char   line[MAX_LINE];
+    frame *current = NULL;
+    int    pixels  = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        line_number++;
+        char *comment = strstr(line, "//");
+        if (comment != NULL)
+        {
+            *comment = 0;
+        }
+        char *end = line + strlen(line);
+        while (end > line && isspace((unsigned char)end[-1]))
+        {
+            *--end = 0;
+        }
+        if (line[0] == 0)
+        {
+            continue;
+        }
+
+        int hold;
+        if (sscanf(line, "frame %d", &hold) == 1)
+        {
+            if (current != NULL && pixels != PIXELS)
+            {
+                fail("frame before is not 30 pixels");
+            }
+            if (hold < 1 || hold > MAX_HOLD)
+            {
+                fail("hold out of 1 to 127");
+            }
+            if (frame_count == MAX_FRAMES)
+            {
+                fail("too many frames");
+            }
+            current       = &frames[frame_count++];
+            current->hold = hold;
+            pixels        = 0;
+            continue;
+        }
+        if (current == NULL)
+        {
+            fail("pixels before the first frame line");
+        }
+        for (char *c = line; *c != 0; c++)
+        {
+            int level = (*c == '.') ? 0 : isxdigit((unsigned char)*c) ? strtol((char[]){*c, 0}, NULL, 16) : -1;
+            if (level < 0)
+            {
+                fail("pixel is not '.' or a hex digit");
+            }
+            if (pixels == PIXELS)
+            {
+                fail("more than 30 pixels in the frame");
+            }
+            current->levels[pixels++] = level;
+        }
+    }
+    if (current == NULL || pixels != PIXELS)
+    {
+        fail("last frame is not 30 pixels");
+    }
+}
+
+// Whether a run of level can set the n pixels, with recolor only the lit ones of the frame before
+static int run_fits(const uint8_t *levels, const uint8_t *before, uint8_t level, int n, int recolor)
+{
+    for (int k = 0; k < n; k++)
+    {
+        if (levels[k] != ((recolor && before[k] == 0) ? 0 : level))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Fewest bytes for levels, or with a frame before, for the changes from it, with runs as the recolor flag says.
+// Tokens are written to out, returns the bytes.
+static int encode_frame(const uint8_t *levels, const uint8_t *before, int recolor, uint8_t *out)
+{
+    // cost[i] is the fewest bytes for pixels i to the end, token[i], count[i] and level[i] the first token of it.
+    int cost[PIXELS + 1], token[PIXELS], count[PIXELS], level[PIXELS];
+    cost[PIXELS] = 0;
+    for (int i = PIXELS - 1; i >= 0; i--)
+    {
+        cost[i] = 1 << 30;
+        for (int n = 1; i + n <= PIXELS && n <= MAX_COUNT; n++)
+        {
+            if (before != NULL && memcmp(&levels[i], &before[i], n) == 0 && 1 + cost[i + n] < cost[i])
+            {
+                cost[i] = 1 + cost[i + n], token[i] = TOKEN_SKIP, count[i] = n;
+            }
+            for (int l = 0; l < 16 && n <= MAX_RUN; l++)
+            {
+                if (run_fits(&levels[i], before ? &before[i] : NULL, l, n, recolor) && 1 + cost[i + n] < cost[i])
+                {
+                    cost[i] = 1 + cost[i + n], token[i] = TOKEN_RUN, count[i] = n, level[i] = l;
+                }
+            }
+            if (1 + (n + 1) / 2 + cost[i + n] < cost[i])
+            {
+                cost[i] = 1 + (n + 1) / 2 + cost[i + n], token[i] = TOKEN_LITERAL, count[i] = n;
+            }
+        }
+    }
+
+    uint8_t *o = out;
+    for (int i = 0; i < PIXELS; i += count[i])
+    {
+        int n = count[i];
+        if (token[i] == TOKEN_RUN)
+        {
+            *o++ = TOKEN_RUN | level[i] << 3 | (n - 1);
+        }
+        else
+        {
+            *o++ = token[i] | (n - 1);
+        }
+        if (token[i] == TOKEN_LITERAL)
+        {
+            for (int k = 0; k < n; k += 2)
+            {
+                *o++ = levels[i + k] | ((k + 1 < n) ? levels[i + k + 1] << 4 : 0);
+            }
+        }
+    }
+    return o - out;
+}
+
+// Decode a frame over the frame before the way led_stream_next() does, returns the bytes read
+static int decode_frame(const uint8_t *in, uint8_t *levels)
+{
+    const uint8_t *d       = in;
+    int            recolor = *d++ & RECOLOR;
+    for (int p = 0; p < PIXELS;)
+    {
+        uint8_t t = *d++;
+        if (t & TOKEN_RUN)
+        {
+            for (int n = (t & 0x07) + 1; n > 0 && p < PIXELS; n--, p++)
+            {
+                if (!recolor || levels[p] != 0)
+                {
+                    levels[p] = (t >> 3) & 0x0f;
+                }
+            }
+        }
+        else if (t & TOKEN_LITERAL)
+        {
+            for (int n = (t & 0x3f) + 1, k = 0; k < n && p < PIXELS; k++)
+            {
+                levels[p++] = (k & 1) ? d[k >> 1] >> 4 : d[k >> 1] & 0x0f;
+            }
+            d += ((t & 0x3f) + 2) >> 1;
+        }
+        else
+        {
+            p += (t & 0x3f) + 1;
+        }
+    }
+    return d - in;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || argc - 2 > MAX_STREAMS)
+    {
+        fprintf(stderr, "usage: %s led_streams.h stream.txt...\n", argv[0]);
+        return 2;
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(out, "// Generated by tools/stream_encoder, run `make streams` instead of editing.\n\n");
+
+    char names[MAX_STREAMS][64];
+    int  total_bytes = 0, total_frames = 0;
+    for (int s = 0; s < argc - 2; s++)
+    {
+        source      = argv[s + 2];
+        line_number = 0;
+        frame_count = 0;
+        FILE *f     = fopen(source, "r");
+        if (f == NULL)
+        {
+            perror(source);
+            return 1;
+        }
+        read_frames(f);
+        fclose(f);
+        line_number = 0;
+
+        // Stream name from the file name, streams/heart.txt is led_stream_heart
+        const char *base = strrchr(source, '/') ? strrchr(source, '/') + 1 : source;
+        int         len  = strcspn(base, ".");
+        snprintf(names[s], sizeof(names[s]), "led_stream_%.*s", len < 40 ? len : 40, base);
+
+        uint8_t bytes[MAX_BYTES];
+        int     size = 0;
+        bytes[size++] = frame_count;
+        fprintf(out, "// %s, %d frames\nstatic const uint8_t %s[] LED_ASSET = {\n    %d,\n", source, frame_count,
+                names[s], frame_count);
+        for (int i = 0; i < frame_count; i++)
+        {
+            // The smaller of the frame without and with the recolor flag, a keyframe has no frame before
+            const uint8_t *before = i ? frames[i - 1].levels : NULL;
+            uint8_t        plain[PIXELS * 2], recolored[PIXELS * 2];
+            int            plain_size     = encode_frame(frames[i].levels, before, 0, plain);
+            int            recolored_size = before ? encode_frame(frames[i].levels, before, 1, recolored) : 1 << 30;
+            int            recolor        = recolored_size < plain_size;
+            int            start          = size;
+            bytes[size++]                 = frames[i].hold | (recolor ? RECOLOR : 0);
+            memcpy(&bytes[size], recolor ? recolored : plain, recolor ? recolored_size : plain_size);
+            size += recolor ? recolored_size : plain_size;
+
+            // Check by decoding over the frame before
+            uint8_t levels[PIXELS] = {0};
+            if (before != NULL)
+            {
+                memcpy(levels, before, PIXELS);
+            }
+            if (decode_frame(&bytes[start], levels) != size - start || memcmp(levels, frames[i].levels, PIXELS) != 0)
+            {
+                fail("frame does not decode back");
+            }
+
+            fprintf(out, "   ");
+            for (int b = start; b < size; b++)
+            {
+                fprintf(out, " 0x%02x,", bytes[b]);
+            }
+            fprintf(out, "  // %s %d\n", i == 0 ? "key" : recolor ? "recolor" : "delta", i);
+        }
+        fprintf(out, "};\n\n");
+
+        int raw = frame_count * PIXELS;
+        printf("%-24s %3d frames, %4d bytes, %5d as 30-byte frames (%.1f:1), %5d as packed nibbles (%.1f:1)\n",
+               names[s], frame_count, size, raw, (double)raw / size, raw / 2, (double)raw / 2 / size);
+        total_bytes += size;
+        total_frames += frame_count;
+    }
+
+    fprintf(out, "#define LED_STREAMS %d\n\n", argc - 2);
+    fprintf(out, "static const uint8_t *const led_streams[LED_STREAMS] LED_ASSET = {\n");
+    for (int s = 0; s < argc - 2; s++)
+    {
+        fprintf(out, "    %s,\n", names[s]);
+    }
+    fprintf(out, "};\n");
+    fclose(out);
+
+    printf("%d streams, %d frames in %d bytes, %.1f:1 against 30-byte frames, written to %s\n", argc - 2,
+           total_frames, total_bytes, (double)total_frames * PIXELS / total_bytes, argv[1]);
+    return 0;
+}